@@ -2,26 +2,81 @@
 // SPDX-License-Identifier: BSD-3-Clause-Clear
 
 #include <string>
+#include <vector>
+#include <cstdlib>
 #include <dirent.h>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <utility>
 #include <memory>
 #include <mutex>
+#include <deque>
+#include <thread>
+#include <condition_variable>
+#include <cerrno>
+#include <unistd.h>
+#include <unordered_map>
 
 #include "Helpers.h"
+#include "Tracing.h"
+#include "ExtLogger.h"
+#include "SignalTiers.h"
+#include "ProcExitWatcher.h"
+
+// Load a single pipeline contributes to the system-wide totals.
+typedef struct {
+    int32_t  mStreams;          // Encoder elements in the pipeline
+    int32_t  mDecoderThreads;   // Decoder threads found under /proc/<pid>/task
+    uint64_t mPixelRate;        // width * height * fps, 0 if not in the cmdline
+} SessionLoad;
+
+// Signal acquired on behalf of a pipeline, held until the process exits.
+typedef struct {
+    int64_t               mHandle;
+    uint32_t              mSigId;
+    uint32_t              mSigType;
+    std::vector<uint32_t> mExtraArgs;   // Empty if the cmdline carried none
+    SessionLoad           mLoad;
+} ActiveSession;
+
+// Signal held by the plugin itself for the combined load of all pipelines
+// of one kind, acquired on behalf of the URM process.
+typedef struct {
+    uint32_t  mSigId;
+    uint32_t  mSigType;
+    int64_t   mHandle;
+    std::vector<uint32_t> mExtraArgs;
+} AggregateSignal;
 
 class PostProcessingBlock {
 private:
     static std::once_flag mInitFlag;
     static std::unique_ptr<PostProcessingBlock> mInstance;
 
+    std::mutex mSessionLock;
+    std::unordered_map<pid_t, ActiveSession> mSessions;
+
+    // Serializes aggregate updates, taken before mSessionLock.
+    std::mutex mAggregateLock;
+    AggregateSignal mEncodeAggregate;
+    AggregateSignal mDecodeAggregate;
+
+    // Exits reported by the shared ProcExitWatcher thread, released here so
+    // the URM calls never run on that thread.
+    std::mutex mExitLock;
+    std::condition_variable mExitWake;
+    std::thread mExitThread;
+    std::deque<pid_t> mExitedPids;
+    bool mStop;
+
 private:
     inline void    SanitizeNulls(char *buf, int32_t len);
     inline int32_t ReadFirstLine(const std::string& filePath, std::string &line);
     inline void    to_lower(std::string &s);
     int32_t        countThreadsWithName(pid_t pid, const std::string& commSub);
-    int32_t        fetchUsecaseDetails(int32_t pid, char *buf, uint32_t &sigId, uint32_t &sigType, uint32_t** extraArgs);
+    int32_t        fetchUsecaseDetails(int32_t pid, char *buf, uint32_t &sigId, uint32_t &sigType,
+                                       uint32_t** extraArgs, SessionLoad& load);
     int32_t        countEncoders(const char* buffer, const char* encoderStr);
     std::string    extractSourceName(const char* buffer, const char* namePrefix, const char* defaultName);
     uint32_t       extractFrameRate(const char* buffer, const char* frameRatePrefix);
@@ -30,8 +85,16 @@ private:
 
     uint32_t       calculateEncoderSigType(int32_t count);
     uint32_t       calculateDecoderSigType(int32_t threadCount);
-
-    PostProcessingBlock() = default;
+    void           dropSession(pid_t pid, const ActiveSession& session);
+    void           updateAggregate(AggregateSignal& aggregate, uint32_t pipelines,
+                                   uint32_t sigType, const uint32_t* extraArgs);
+    void           refreshAggregates();
+    void           exitLoop();
+
+    PostProcessingBlock() : mStop(false) {
+        mEncodeAggregate = {URM_SIG_CAMERA_ENCODE_MULTI_STREAMS, 0, 0, {}};
+        mDecodeAggregate = {URM_SIG_VIDEO_DECODE, 0, 0, {}};
+    }
     PostProcessingBlock(const PostProcessingBlock&) = delete;
     PostProcessingBlock& operator=(const PostProcessingBlock&) = delete;
 
@@ -43,10 +106,24 @@ public:
         return *mInstance;
     }
 
-    ~PostProcessingBlock() = default;
-    void PostProcess(pid_t pid, uint32_t &sigId, uint32_t &sigType, uint32_t** extraArgs);
+    ~PostProcessingBlock();
+    int32_t PostProcess(pid_t pid, uint32_t &sigId, uint32_t &sigType, uint32_t** extraArgs, SessionLoad& load);
+    void trackSession(pid_t pid, const ActiveSession& session);
+    void releaseSession(pid_t pid);
+    void queueExit(pid_t pid);
 };
 
+PostProcessingBlock::~PostProcessingBlock() {
+    {
+        const std::lock_guard<std::mutex> lock(mExitLock);
+        mStop = true;
+    }
+    mExitWake.notify_all();
+    if(mExitThread.joinable()) {
+        mExitThread.join();
+    }
+}
+
 inline void PostProcessingBlock::SanitizeNulls(char *buf, int32_t len) {
     /* /proc/<pid>/cmdline contains null charaters instead of spaces
      * sanitize those null characters with spaces such that char*
@@ -95,23 +172,22 @@ int32_t PostProcessingBlock::countThreadsWithName(pid_t pid, const std::string&
 
     int32_t count = 0;
     struct dirent* entry;
+    to_lower(commSubStr);
     while((entry = readdir(dir)) != nullptr) {
+        // Skip "." and "..", they have no comm of their own.
+        if(entry->d_name[0] == '.') {
+            continue;
+        }
         std::string threadNamePath = threadsListPath + std::string(entry->d_name) + "/comm";
 
+        // A thread exiting during the walk does not invalidate the others.
         std::ifstream fileStream(threadNamePath, std::ios::in);
-        if(!fileStream.is_open()) {
-            closedir(dir);
-            return 0;
-        }
-
         std::string value = "";
-        if(!getline(fileStream, value)) {
-            closedir(dir);
-            return 0;
+        if(!fileStream.is_open() || !getline(fileStream, value)) {
+            continue;
         }
 
         to_lower(value);
-        to_lower(commSubStr);
         if(value.find(commSubStr) != std::string::npos) {
             count++;
         }
@@ -254,16 +330,16 @@ uint32_t PostProcessingBlock::calculateEncoderSigType(int32_t count) {
  *
  * @return sigType value based on decoder load classification:
  *         0 for low load (0-4 threads)
- *         5 for medium load (5-20 threads)
- *         21 for high load (20+ threads)
+ *         5 for medium load (5-19 threads)
+ *         20 for high load (20+ threads)
  */
 uint32_t PostProcessingBlock::calculateDecoderSigType(int32_t threadCount) {
     if (threadCount < 5){
         return 0;
-    } else if (threadCount >= 5 && threadCount <= 20) {
+    } else if (threadCount < 20) {
         return 5;
     } else {
-        return 21;
+        return 20;
     }
 }
 
@@ -271,7 +347,8 @@ int32_t PostProcessingBlock::fetchUsecaseDetails(int32_t pid,
                                                  char *buf,
                                                  uint32_t& sigId,
                                                  uint32_t& sigType,
-                                                 uint32_t** extraArgs) {
+                                                 uint32_t** extraArgs,
+                                                 SessionLoad& load) {
     // GStreamer element identifiers for different video operations
     const std::vector<const char*> encoderList = {
         "v4l2h264enc",    // Hardware H.264 encoder element
@@ -311,10 +388,14 @@ int32_t PostProcessingBlock::fetchUsecaseDetails(int32_t pid,
     (*extraArgs)[SIGNAL_EXTRA_ATTR_WIDTH] = extractWidth(buf);
     (*extraArgs)[SIGNAL_EXTRA_ATTR_SRC_ELEMENT] = srcElement;
 
-    LOGD("CAM_BLOCK", "Printing Query Stats");
-    LOGD("CAM_BLOCK", "fps=" + std::to_string((*extraArgs)[SIGNAL_EXTRA_ATTR_FPS]));
-    LOGD("CAM_BLOCK", "height=" + std::to_string((*extraArgs)[SIGNAL_EXTRA_ATTR_HEIGHT]));
-    LOGD("CAM_BLOCK", "width=" + std::to_string((*extraArgs)[SIGNAL_EXTRA_ATTR_WIDTH]));
+    load.mPixelRate = static_cast<uint64_t>((*extraArgs)[SIGNAL_EXTRA_ATTR_WIDTH]) *
+                      (*extraArgs)[SIGNAL_EXTRA_ATTR_HEIGHT] *
+                      (*extraArgs)[SIGNAL_EXTRA_ATTR_FPS];
+
+    EXT_LOGD("CAM_BLOCK", "Query Stats: fps={} height={} width={}",
+             (*extraArgs)[SIGNAL_EXTRA_ATTR_FPS],
+             (*extraArgs)[SIGNAL_EXTRA_ATTR_HEIGHT],
+             (*extraArgs)[SIGNAL_EXTRA_ATTR_WIDTH]);
 
     // Check for encoder
     const char* matchedEncoder = nullptr;
@@ -328,11 +409,12 @@ int32_t PostProcessingBlock::fetchUsecaseDetails(int32_t pid,
     if(matchedEncoder != nullptr) {
         std::string sourceName = extractSourceName(buf, namePrefix, defaultName);
         int32_t encoderCount = countEncoders(buf, matchedEncoder);
+        load.mStreams = encoderCount;
 
         // Encode Multi stream case
         if (encoderCount > 1) {
             sigId = URM_SIG_CAMERA_ENCODE_MULTI_STREAMS;
-            sigType = calculateEncoderSigType(encoderCount);
+            sigType = resolveSignalTier(sigId, calculateEncoderSigType(encoderCount));
         } else {
             // Encode single stream case
             sigId = URM_SIG_CAMERA_ENCODE;
@@ -352,8 +434,9 @@ int32_t PostProcessingBlock::fetchUsecaseDetails(int32_t pid,
 
     if(matchedDecoder != nullptr) {
         int32_t numSources = countThreadsWithName(pid, matchedDecoder);
+        load.mDecoderThreads = numSources;
         sigId = URM_SIG_VIDEO_DECODE;
-        sigType = calculateDecoderSigType(numSources);
+        sigType = resolveSignalTier(sigId, calculateDecoderSigType(numSources));
         return 0;
     }
 
@@ -366,28 +449,270 @@ int32_t PostProcessingBlock::fetchUsecaseDetails(int32_t pid,
     return -1;
 }
 
-void PostProcessingBlock::PostProcess(pid_t pid,
-                                      uint32_t &sigId,
-                                      uint32_t &sigType,
-                                      uint32_t** extraArgs) {
+// Returns 0 if the cmdline matched a camera / video workload, -1 otherwise.
+int32_t PostProcessingBlock::PostProcess(pid_t pid,
+                                         uint32_t &sigId,
+                                         uint32_t &sigType,
+                                         uint32_t** extraArgs,
+                                         SessionLoad& load) {
 	std::string cmdline;
     std::string cmdLinePath = "/proc/" + std::to_string(pid) + "/cmdline";
 
     if(ReadFirstLine(cmdLinePath, cmdline) <= 0) {
-        return;
+        return -1;
     }
 
     char* buf = (char*)cmdline.data();
     size_t sz = cmdline.size();
 
     SanitizeNulls(buf, sz);
-    fetchUsecaseDetails(pid, buf, sigId, sigType, extraArgs);
+    return fetchUsecaseDetails(pid, buf, sigId, sigType, extraArgs, load);
+}
+
+void PostProcessingBlock::dropSession(pid_t pid, const ActiveSession& session) {
+    {
+        TraceScope scope(TRACE_EV_RELEASE, TRACE_CB_CAM_POSTPROCESS, session.mSigId);
+        scope.mResult = releaseSignal(session.mHandle, pid, pid);
+    }
+}
+
+/**
+ * @brief Remember the signal acquired for pid and release it as soon as the
+ *        process exits, instead of waiting for URM to notice.
+ */
+void PostProcessingBlock::trackSession(pid_t pid, const ActiveSession& session) {
+    ActiveSession stale;
+    bool replaced = false;
+    {
+        const std::lock_guard<std::mutex> lock(mSessionLock);
+        auto it = mSessions.find(pid);
+        if(it != mSessions.end()) {
+            stale = it->second;
+            replaced = true;
+        }
+        mSessions[pid] = session;
+    }
+
+    if(replaced) {
+        // Same process exec'd another pipeline, its exit is already watched.
+        dropSession(pid, stale);
+        refreshAggregates();
+        return;
+    }
+
+    int rc = watchProcessExit(pid, [](pid_t exitedPid) {
+        PostProcessingBlock::getInstance().queueExit(exitedPid);
+    });
+
+    if(rc == ESRCH) {
+        // Pipeline ended before the watch was armed.
+        releaseSession(pid);
+    } else if(rc != 0) {
+        // No pidfd support, URM releases the handle once it notices the exit.
+        // The pipeline is left out of the totals as its exit would go unseen.
+        EXT_LOGD("CAM_BLOCK", "Exit watch unavailable for pid {}: {}", pid, ExtErrno{rc});
+        const std::lock_guard<std::mutex> lock(mSessionLock);
+        mSessions.erase(pid);
+    } else {
+        refreshAggregates();
+    }
+}
+
+void PostProcessingBlock::releaseSession(pid_t pid) {
+    ActiveSession session;
+    {
+        const std::lock_guard<std::mutex> lock(mSessionLock);
+        auto it = mSessions.find(pid);
+        if(it == mSessions.end()) {
+            return;
+        }
+        session = it->second;
+        mSessions.erase(it);
+    }
+
+    dropSession(pid, session);
+    refreshAggregates();
+}
+
+/**
+ * @brief Hand an exited pipeline over to the exit thread.
+ *
+ * Called on the ProcExitWatcher thread, which must not block. Releasing the
+ * session and updating the aggregates calls into URM, so that is done here
+ * on a thread of our own.
+ */
+void PostProcessingBlock::queueExit(pid_t pid) {
+    {
+        const std::lock_guard<std::mutex> lock(mExitLock);
+        if(mStop) return;
+        mExitedPids.push_back(pid);
+        if(!mExitThread.joinable()) {
+            mExitThread = std::thread(&PostProcessingBlock::exitLoop, this);
+        }
+    }
+    mExitWake.notify_one();
+}
+
+void PostProcessingBlock::exitLoop() {
+    for(;;) {
+        pid_t pid = 0;
+        {
+            std::unique_lock<std::mutex> lock(mExitLock);
+            mExitWake.wait(lock, [this] { return mStop || !mExitedPids.empty(); });
+            if(mStop) return;
+            pid = mExitedPids.front();
+            mExitedPids.pop_front();
+        }
+        releaseSession(pid);
+    }
+}
+
+/**
+ * @brief Bring one aggregate signal in line with the current totals.
+ *
+ * The aggregate is only held while at least two pipelines of its kind are
+ * live, a single pipeline is already covered by its own signal. Tier changes
+ * go through transitionSignal() so nodes both tiers agree on stay applied.
+ */
+void PostProcessingBlock::updateAggregate(AggregateSignal& aggregate,
+                                          uint32_t pipelines,
+                                          uint32_t sigType,
+                                          const uint32_t* extraArgs) {
+    pid_t self = getpid();
+
+    if(pipelines < 2) {
+        if(aggregate.mHandle > 0) {
+            TraceScope scope(TRACE_EV_RELEASE, TRACE_CB_CAM_POSTPROCESS, aggregate.mSigId);
+            scope.mResult = releaseSignal(aggregate.mHandle, self, self);
+        }
+        aggregate.mHandle = 0;
+        aggregate.mExtraArgs.clear();
+        return;
+    }
+
+    // acquireSignal() copies the extra args, the vector only remembers what
+    // the held handle was acquired with.
+    std::vector<uint32_t> args(extraArgs, extraArgs + SIGNAL_EXTRA_ATTRS_COUNT);
+
+    int64_t handle = 0;
+    if(aggregate.mHandle <= 0) {
+        TraceScope scope(TRACE_EV_ACQUIRE, TRACE_CB_CAM_POSTPROCESS, aggregate.mSigId);
+        handle = acquireSignal(aggregate.mSigId, sigType, self, self, SIGNAL_EXTRA_ATTRS_COUNT, args.data());
+        scope.mResult = handle;
+    } else {
+        handle = transitionSignal(aggregate.mHandle, aggregate.mSigId,
+                                  aggregate.mSigType, sigType, self, args.data());
+    }
+
+    if(handle <= 0 || handle == aggregate.mHandle) {
+        // Nothing new acquired, a failed switch is retried on the next update.
+        return;
+    }
+
+    aggregate.mHandle = handle;
+    aggregate.mSigType = sigType;
+    aggregate.mExtraArgs = std::move(args);
+}
+
+/**
+ * @brief Recompute the system-wide totals and update the aggregate signals.
+ *
+ * Each pipeline is classified from its own cmdline, so N single stream
+ * encoders would each land on the lowest tier. The totals across all live
+ * pipelines select the tier of one aggregate signal per workload kind.
+ */
+void PostProcessingBlock::refreshAggregates() {
+    const std::lock_guard<std::mutex> aggregateLock(mAggregateLock);
+
+    uint32_t encPipelines = 0, decPipelines = 0;
+    int32_t encStreams = 0, decThreads = 0;
+    uint64_t pixelRate = 0;
+    uint32_t encArgs[SIGNAL_EXTRA_ATTRS_COUNT] = {0};
+    uint32_t decArgs[SIGNAL_EXTRA_ATTRS_COUNT] = {0};
+    {
+        const std::lock_guard<std::mutex> lock(mSessionLock);
+        for(const auto& kv : mSessions) {
+            const ActiveSession& session = kv.second;
+            uint32_t* args = nullptr;
+
+            if(session.mSigId == URM_SIG_CAMERA_ENCODE ||
+               session.mSigId == URM_SIG_CAMERA_ENCODE_MULTI_STREAMS) {
+                encPipelines++;
+                encStreams += std::max(session.mLoad.mStreams, 1);
+                args = encArgs;
+            } else if(session.mSigId == URM_SIG_VIDEO_DECODE) {
+                decPipelines++;
+                decThreads += session.mLoad.mDecoderThreads;
+                args = decArgs;
+            } else {
+                continue;
+            }
+
+            // Aggregate attributes describe the most demanding pipeline.
+            pixelRate += session.mLoad.mPixelRate;
+            if(!session.mExtraArgs.empty()) {
+                for(uint32_t i = 0; i < SIGNAL_EXTRA_ATTRS_COUNT; i++) {
+                    args[i] = std::max(args[i], session.mExtraArgs[i]);
+                }
+            }
+        }
+    }
+
+    EXT_LOGI("CAM_BLOCK", "Live pipelines: encode={} streams={} decode={} threads={} pixelRate={}",
+             encPipelines, encStreams, decPipelines, decThreads, pixelRate);
+
+    // Not every target defines every tier, fall back to the closest lower one.
+    updateAggregate(mEncodeAggregate, encPipelines,
+                    resolveSignalTier(mEncodeAggregate.mSigId, calculateEncoderSigType(encStreams)), encArgs);
+    updateAggregate(mDecodeAggregate, decPipelines,
+                    resolveSignalTier(mDecodeAggregate.mSigId, calculateDecoderSigType(decThreads)), decArgs);
 }
 
 std::once_flag PostProcessingBlock::mInitFlag;
 std::unique_ptr<PostProcessingBlock> PostProcessingBlock::mInstance = nullptr;
 
-static void WorkloadPostprocessCallback(void* context) {
+// Short-lived boost held while a pipeline is being classified, see
+// CAM_LAUNCH_BOOST in SignalsConfig.yaml. The SigType is fixed per
+// registered process name, nothing of the cmdline is looked at.
+static const uint32_t SIG_CAM_LAUNCH_BOOST = CONSTRUCT_SIG_CODE(0xea, 0x0001);
+static constexpr uint32_t LAUNCH_BOOST_TYPE_GST_LAUNCH = 0;
+static constexpr uint32_t LAUNCH_BOOST_TYPE_CAMERA_APP = 1;
+
+static inline bool isLaunchBoostEnabled() {
+    // On by default, URM_EXT_LAUNCH_BOOST=0 turns it off.
+    static const bool enabled = std::getenv("URM_EXT_LAUNCH_BOOST") == nullptr ||
+                                parseBoolEnv(std::getenv("URM_EXT_LAUNCH_BOOST"));
+    return enabled;
+}
+
+static int64_t acquireLaunchBoost(pid_t pid, uint32_t boostType) {
+    if(!isLaunchBoostEnabled()) {
+        return 0;
+    }
+    TraceScope scope(TRACE_EV_ACQUIRE, TRACE_CB_CAM_POSTPROCESS, SIG_CAM_LAUNCH_BOOST);
+    scope.mResult = acquireSignal(SIG_CAM_LAUNCH_BOOST, boostType, pid, pid, 0, nullptr);
+    return scope.mResult;
+}
+
+static void releaseLaunchBoost(pid_t pid, int64_t handle) {
+    if(handle <= 0) {
+        return;
+    }
+    TraceScope scope(TRACE_EV_RELEASE, TRACE_CB_CAM_POSTPROCESS, SIG_CAM_LAUNCH_BOOST);
+    scope.mResult = releaseSignal(handle, pid, pid);
+}
+
+/**
+ * @brief Classify the pipeline and acquire its signal.
+ *
+ * Reading and scanning the cmdline, and the task walk for decoders, take a
+ * while, and the pipeline start-up (caps negotiation, buffer allocation,
+ * camera open) would run unboosted meanwhile. The launch boost is therefore
+ * acquired first and only released once the classified signal is held, or
+ * right after classification if nothing matched. Its Timeout bounds it should
+ * the release never happen.
+ */
+static void WorkloadPostprocess(void* context, uint32_t boostType) {
     if(context == nullptr) {
         return;
     }
@@ -401,16 +726,58 @@ static void WorkloadPostprocessCallback(void* context) {
     uint32_t sigId = cbData->mSigId;
     uint32_t sigType = cbData->mSigType;
 
+    int64_t boostHandle = acquireLaunchBoost(pid, boostType);
+
     uint32_t* extraArgs = nullptr;
-    PostProcessingBlock::getInstance().PostProcess(pid, sigId, sigType, &extraArgs);
+    SessionLoad load = {0, 0, 0};
+    int32_t matched = -1;
+    {
+        TraceScope scope(TRACE_EV_CLASSIFY, TRACE_CB_CAM_POSTPROCESS, sigId);
+        matched = PostProcessingBlock::getInstance().PostProcess(pid, sigId, sigType, &extraArgs, load);
+        scope.mResCode = sigId;
+        scope.mResult = sigType;
+    }
 
-    int64_t handle =
-        acquireSignal(sigId, sigType, pid, pid, SIGNAL_EXTRA_ATTRS_COUNT, extraArgs);
+    if(matched != 0) {
+        // Not a camera / video pipeline, drop the boost before the generic
+        // launch signal goes in.
+        releaseLaunchBoost(pid, boostHandle);
+        boostHandle = 0;
+    }
+
+    int64_t handle = 0;
+    {
+        TraceScope scope(TRACE_EV_ACQUIRE, TRACE_CB_CAM_POSTPROCESS, sigId);
+        handle = acquireSignal(sigId, sigType, pid, pid, SIGNAL_EXTRA_ATTRS_COUNT, extraArgs);
+        scope.mResult = handle;
+    }
     cbData->mHandleAcq = handle;
+
+    // Swap complete. If the acquire failed the boost goes as well rather
+    // than lingering until its timeout.
+    releaseLaunchBoost(pid, boostHandle);
+
+    if(handle > 0) {
+        ActiveSession session = {handle, sigId, sigType, {}, load};
+        if(extraArgs != nullptr) {
+            session.mExtraArgs.assign(extraArgs, extraArgs + SIGNAL_EXTRA_ATTRS_COUNT);
+        }
+        PostProcessingBlock::getInstance().trackSession(pid, session);
+    }
+    // acquireSignal() and the session both keep their own copy.
+    delete[] extraArgs;
+}
+
+static void WorkloadPostprocessCallback(void* context) {
+    WorkloadPostprocess(context, LAUNCH_BOOST_TYPE_GST_LAUNCH);
+}
+
+static void CameraAppPostprocessCallback(void* context) {
+    WorkloadPostprocess(context, LAUNCH_BOOST_TYPE_CAMERA_APP);
 }
 
 __attribute__((constructor))
 static void registerWithUrm() {
     URM_REGISTER_POST_PROCESS_CB("gst-launch-1.0", WorkloadPostprocessCallback)
-    URM_REGISTER_POST_PROCESS_CB("gst-camera-per-port-example", WorkloadPostprocessCallback)
+    URM_REGISTER_POST_PROCESS_CB("gst-camera-per-port-example", CameraAppPostprocessCallback)
 }
@@ -0,0 +1,147 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <cstdlib>
+
+#include "Helpers.h"
+#include "ExtLogger.h"
+#include "CgroupNames.h"
+
+#define URM_COMMON_CONFIG_DIR "/etc/urm/common/"
+
+class CgroupNameRegistry {
+private:
+    static std::once_flag mInitFlag;
+    static std::unique_ptr<CgroupNameRegistry> mInstance;
+
+    std::mutex mLock;
+    std::map<int32_t, std::string> mNames;
+
+    void parseConfigFile(const std::string& filePath);
+
+    CgroupNameRegistry() = default;
+    CgroupNameRegistry(const CgroupNameRegistry&) = delete;
+    CgroupNameRegistry& operator=(const CgroupNameRegistry&) = delete;
+
+public:
+    static CgroupNameRegistry& getInstance() {
+        std::call_once(mInitFlag, [] {
+            mInstance.reset(new CgroupNameRegistry());
+            mInstance->load();
+        });
+        return *mInstance;
+    }
+
+    ~CgroupNameRegistry() = default;
+    void load();
+    bool getName(int32_t cgroupId, std::string& name);
+};
+
+std::once_flag CgroupNameRegistry::mInitFlag;
+std::unique_ptr<CgroupNameRegistry> CgroupNameRegistry::mInstance = nullptr;
+
+static size_t indentOf(const std::string& line) {
+    size_t pos = line.find_first_not_of(' ');
+    return pos == std::string::npos ? line.size() : pos;
+}
+
+// Accepts both block and flow style entries:
+//   - CgroupsInfo:
+//     - Name: "camera-cgroup"
+//       ID: 0
+//     - {Name: "audio-cgroup", ID: 1}
+void CgroupNameRegistry::parseConfigFile(const std::string& filePath) {
+    std::ifstream fileStream(filePath, std::ios::in);
+    if(!fileStream.is_open()) {
+        return;
+    }
+
+    bool inSection = false;
+    size_t sectionIndent = 0;
+    std::string name;
+    std::string id;
+
+    auto commit = [&]() {
+        if(!name.empty() && !id.empty()) {
+            mNames[static_cast<int32_t>(strtol(id.c_str(), nullptr, 0))] = name;
+        }
+        name.clear();
+        id.clear();
+    };
+
+    std::string line;
+    while(getline(fileStream, line)) {
+        std::string s = trim(line);
+        if(s.empty() || s[0] == '#') {
+            continue;
+        }
+
+        size_t indent = indentOf(line);
+        if(s.find("CgroupsInfo:") != std::string::npos) {
+            commit();
+            inSection = true;
+            sectionIndent = indent;
+            continue;
+        }
+        if(!inSection) {
+            continue;
+        }
+        if(indent <= sectionIndent) {
+            commit();
+            inSection = false;
+            continue;
+        }
+
+        if(s.compare(0, 2, "- ") == 0) {
+            commit();
+        }
+
+        std::string v = flowField(s, "Name");
+        if(!v.empty()) name = v;
+        v = flowField(s, "ID");
+        if(!v.empty()) id = v;
+    }
+    commit();
+    fileStream.close();
+}
+
+void CgroupNameRegistry::load() {
+    const std::lock_guard<std::mutex> lock(mLock);
+
+    std::string machineName;
+    fetchMachineName(machineName);
+    mNames.clear();
+
+    // Later files override earlier ones, same as URM's own config order.
+    parseConfigFile(std::string(URM_COMMON_CONFIG_DIR) + "InitConfig.yaml");
+    parseConfigFile(std::string(URM_TARGET_CONFIG_DIR) + "InitConfig.yaml");
+    if(!machineName.empty()) {
+        parseConfigFile(std::string(URM_TARGET_CONFIG_DIR) + machineName + "/InitConfig.yaml");
+    }
+
+    EXT_LOGI("URM_EXT_CGRP", "Loaded {} cgroup names", static_cast<uint32_t>(mNames.size()));
+}
+
+bool CgroupNameRegistry::getName(int32_t cgroupId, std::string& name) {
+    const std::lock_guard<std::mutex> lock(mLock);
+    auto it = mNames.find(cgroupId);
+    if(it == mNames.end()) {
+        return false;
+    }
+    name = it->second;
+    return true;
+}
+
+bool getCgroupPath(int32_t cgroupId, std::string& path) {
+    std::string name;
+    if(!CgroupNameRegistry::getInstance().getName(cgroupId, name)) {
+        return false;
+    }
+    path = std::string(CGROUP_V2_ROOT) + name + "/";
+    return true;
+}
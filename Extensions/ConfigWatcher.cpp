@@ -0,0 +1,269 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+
+#include "Helpers.h"
+#include "ExtLogger.h"
+#include "ConfigWatcher.h"
+
+#define CONFIG_WATCH_SETTLE_MS  300
+#define CONFIG_WATCH_EVENT_BUF  4096
+#define CONFIG_WATCH_RETRY_MS   5000
+#define CONFIG_WATCH_FILE_MASK  (IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE)
+#define CONFIG_WATCH_DIR_MASK   (IN_CREATE | IN_MOVED_TO)
+
+static constexpr const char* kLogTag = "URM_EXT_CONFIG_WATCH";
+
+class ConfigWatcher {
+private:
+    static std::once_flag mInitFlag;
+    static std::unique_ptr<ConfigWatcher> mInstance;
+
+    std::mutex mLock;
+    int mInotifyFd;
+    int mWakeFd;
+    int mParentWd;      // Parent of the target directory while that is missing
+    int mTargetWd;
+    int mMachineWd;
+    std::string mMachineName;
+    std::string mTargetDir;     // URM_TARGET_CONFIG_DIR without the trailing '/'
+    std::string mParentDir;
+    std::string mTargetName;
+    std::thread mThread;
+    std::map<std::string, std::vector<ConfigReloadCallback>> mCallbacks;
+
+    bool armWatches();
+    void addMachineWatch();
+    void markAllChanged(std::set<std::string>& changed);
+    void readEvents(std::set<std::string>& changed);
+    void dispatch(const std::set<std::string>& changed);
+    void pollLoop();
+
+    ConfigWatcher();
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+public:
+    static ConfigWatcher& getInstance() {
+        std::call_once(mInitFlag, [] {
+            mInstance.reset(new ConfigWatcher());
+        });
+        return *mInstance;
+    }
+
+    ~ConfigWatcher();
+    void watch(const std::string& fileName, const ConfigReloadCallback& onChange);
+};
+
+std::once_flag ConfigWatcher::mInitFlag;
+std::unique_ptr<ConfigWatcher> ConfigWatcher::mInstance = nullptr;
+
+ConfigWatcher::ConfigWatcher()
+    : mInotifyFd(-1), mWakeFd(-1), mParentWd(-1), mTargetWd(-1), mMachineWd(-1) {
+    fetchMachineName(mMachineName);
+
+    mTargetDir = URM_TARGET_CONFIG_DIR;
+    while(mTargetDir.size() > 1 && mTargetDir.back() == '/') {
+        mTargetDir.pop_back();
+    }
+    size_t slash = mTargetDir.find_last_of('/');
+    mParentDir = (slash == std::string::npos || slash == 0) ? "/" : mTargetDir.substr(0, slash);
+    mTargetName = (slash == std::string::npos) ? mTargetDir : mTargetDir.substr(slash + 1);
+
+    mInotifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    mWakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(mInotifyFd < 0 || mWakeFd < 0) {
+        TYPELOGV(ERRNO_LOG, strerror(errno));
+        return;
+    }
+
+    if(!armWatches()) {
+        EXT_LOGI(kLogTag, "{} not watchable yet, retrying every {} ms",
+                 mTargetDir, CONFIG_WATCH_RETRY_MS);
+    }
+
+    mThread = std::thread(&ConfigWatcher::pollLoop, this);
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    if(mThread.joinable()) {
+        uint64_t one = 1;
+        ssize_t rc = write(mWakeFd, &one, sizeof(one));
+        (void)rc;
+        mThread.join();
+    }
+    if(mWakeFd >= 0) close(mWakeFd);
+    if(mInotifyFd >= 0) close(mInotifyFd);
+}
+
+/**
+ * @brief Watch the target directory, or its parent while it does not exist.
+ *
+ * A target directory installed after the plugin is loaded is picked up by
+ * the parent watch. If the parent is missing as well, the poll loop calls
+ * this again every CONFIG_WATCH_RETRY_MS.
+ *
+ * @return true if the target directory is watched.
+ */
+bool ConfigWatcher::armWatches() {
+    if(mTargetWd < 0) {
+        // IN_CREATE catches the machine directory being installed later on.
+        mTargetWd = inotify_add_watch(mInotifyFd, mTargetDir.c_str(), CONFIG_WATCH_FILE_MASK | IN_CREATE);
+    }
+    if(mTargetWd >= 0) {
+        if(mParentWd >= 0) {
+            inotify_rm_watch(mInotifyFd, mParentWd);
+            mParentWd = -1;
+        }
+        addMachineWatch();
+        return true;
+    }
+
+    if(mParentWd < 0) {
+        mParentWd = inotify_add_watch(mInotifyFd, mParentDir.c_str(), CONFIG_WATCH_DIR_MASK | IN_ONLYDIR);
+    }
+    return false;
+}
+
+// Files copied in before a watch was armed raise no events, treat all of
+// them as changed.
+void ConfigWatcher::markAllChanged(std::set<std::string>& changed) {
+    const std::lock_guard<std::mutex> lock(mLock);
+    for(const auto& kv : mCallbacks) {
+        changed.insert(kv.first);
+    }
+}
+
+void ConfigWatcher::addMachineWatch() {
+    if(mMachineName.empty() || mMachineWd >= 0) {
+        return;
+    }
+    const std::string dir = std::string(URM_TARGET_CONFIG_DIR) + mMachineName;
+    mMachineWd = inotify_add_watch(mInotifyFd, dir.c_str(), CONFIG_WATCH_FILE_MASK);
+}
+
+void ConfigWatcher::readEvents(std::set<std::string>& changed) {
+    alignas(struct inotify_event) char buf[CONFIG_WATCH_EVENT_BUF];
+    for(;;) {
+        ssize_t len = read(mInotifyFd, buf, sizeof(buf));
+        if(len <= 0) {
+            return;
+        }
+
+        for(char* p = buf; p < buf + len;) {
+            const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + ev->len;
+
+            if(ev->mask & IN_IGNORED) {
+                // Directory removed, re-armed if it is created again.
+                if(ev->wd == mMachineWd) mMachineWd = -1;
+                if(ev->wd == mParentWd) mParentWd = -1;
+                if(ev->wd == mTargetWd) {
+                    mTargetWd = -1;
+                    mMachineWd = -1;
+                    armWatches();
+                }
+                continue;
+            }
+            if(ev->len == 0) continue;
+
+            std::string name = ev->name;
+            if(ev->wd == mParentWd) {
+                if((ev->mask & IN_ISDIR) && name == mTargetName && armWatches()) {
+                    markAllChanged(changed);
+                }
+                continue;
+            }
+            if(ev->mask & IN_ISDIR) {
+                if(ev->wd == mTargetWd && name == mMachineName) {
+                    addMachineWatch();
+                    markAllChanged(changed);
+                }
+                continue;
+            }
+            changed.insert(name);
+        }
+    }
+}
+
+void ConfigWatcher::dispatch(const std::set<std::string>& changed) {
+    for(const std::string& name : changed) {
+        std::vector<ConfigReloadCallback> callbacks;
+        {
+            const std::lock_guard<std::mutex> lock(mLock);
+            auto it = mCallbacks.find(name);
+            if(it == mCallbacks.end()) continue;
+            callbacks = it->second;
+        }
+
+        EXT_LOGI(kLogTag, "reloading {}", name);
+        for(const ConfigReloadCallback& cb : callbacks) {
+            cb();
+        }
+    }
+}
+
+void ConfigWatcher::pollLoop() {
+    std::set<std::string> pending;
+    for(;;) {
+        struct pollfd fds[2] = {{mInotifyFd, POLLIN, 0}, {mWakeFd, POLLIN, 0}};
+        bool unwatched = mTargetWd < 0 && mParentWd < 0;
+        int timeoutMs = !pending.empty() ? CONFIG_WATCH_SETTLE_MS :
+                        (unwatched ? CONFIG_WATCH_RETRY_MS : -1);
+        int n = poll(fds, 2, timeoutMs);
+        if(n < 0) {
+            if(errno == EINTR) continue;
+            TYPELOGV(ERRNO_LOG, strerror(errno));
+            return;
+        }
+        if(fds[1].revents & POLLIN) {
+            return;
+        }
+        if(n == 0 && pending.empty()) {
+            // Neither the target directory nor its parent existed.
+            if(armWatches()) {
+                markAllChanged(pending);
+            }
+            continue;
+        }
+        if(n == 0) {
+            // Quiet for CONFIG_WATCH_SETTLE_MS, the batch is complete.
+            dispatch(pending);
+            pending.clear();
+            continue;
+        }
+        if(fds[0].revents & POLLIN) {
+            readEvents(pending);
+        }
+    }
+}
+
+void ConfigWatcher::watch(const std::string& fileName, const ConfigReloadCallback& onChange) {
+    if(!mThread.joinable()) {
+        return;
+    }
+    const std::lock_guard<std::mutex> lock(mLock);
+    mCallbacks[fileName].push_back(onChange);
+}
+
+void watchConfigFile(const std::string& fileName, const ConfigReloadCallback& onChange) {
+    static const bool enabled = parseBoolEnv(std::getenv("URM_EXT_CONFIG_WATCH"));
+    if(!enabled) {
+        return;
+    }
+    ConfigWatcher::getInstance().watch(fileName, onChange);
+}
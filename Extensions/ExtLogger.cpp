@@ -0,0 +1,251 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <condition_variable>
+
+#include "Helpers.h"
+#include "ExtLogger.h"
+
+#define EXT_LOG_RING_SIZE   128     // Must be a power of 2
+#define EXT_LOG_DRAIN_MS    50
+#define EXT_LOG_LINE_MAX    512
+
+static_assert((EXT_LOG_RING_SIZE & (EXT_LOG_RING_SIZE - 1)) == 0,
+              "EXT_LOG_RING_SIZE must be a power of 2");
+
+// Set once the backend is torn down at unload, later records are discarded.
+static std::atomic<bool> gExtLogShutdown(false);
+
+// Single producer (owning thread), single consumer (drain thread).
+typedef struct {
+    std::atomic<uint32_t> mHead;
+    std::atomic<uint32_t> mTail;
+    std::atomic<uint32_t> mDropped;
+    std::atomic<bool>     mRetired;
+    ExtLogEntry           mEntries[EXT_LOG_RING_SIZE];
+} ExtLogRing;
+
+class ExtLogBackend {
+private:
+    std::mutex mLock;
+    std::condition_variable mWake;
+    std::vector<ExtLogRing*> mRings;
+    std::thread mDrainThread;
+    bool mStop;
+
+    void drainLoop();
+    void drainRing(ExtLogRing* ring);
+    void emit(const ExtLogEntry& entry);
+
+public:
+    ExtLogBackend() : mStop(false) {
+        mDrainThread = std::thread(&ExtLogBackend::drainLoop, this);
+    }
+
+    ~ExtLogBackend() {
+        {
+            const std::lock_guard<std::mutex> lock(mLock);
+            mStop = true;
+        }
+        mWake.notify_one();
+        if(mDrainThread.joinable()) {
+            mDrainThread.join();
+        }
+        // Rings of threads still alive stay allocated, their owners may be
+        // mid-record and the process is going away anyway.
+        gExtLogShutdown.store(true, std::memory_order_release);
+    }
+
+    ExtLogRing* registerRing();
+
+    static ExtLogBackend& getInstance() {
+        static ExtLogBackend instance;
+        return instance;
+    }
+};
+
+// Marks the thread's ring as retired on thread exit, the drain thread frees
+// it once the remaining records have been written out.
+struct ExtLogRingOwner {
+    ExtLogRing* mRing;
+    ExtLogEntry* mPending;
+
+    ExtLogRingOwner() : mRing(nullptr), mPending(nullptr) {}
+    ~ExtLogRingOwner() {
+        if(mRing != nullptr) {
+            mRing->mRetired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+static thread_local ExtLogRingOwner tRingOwner;
+
+ExtLogRing* ExtLogBackend::registerRing() {
+    ExtLogRing* ring = new ExtLogRing();
+    ring->mHead.store(0, std::memory_order_relaxed);
+    ring->mTail.store(0, std::memory_order_relaxed);
+    ring->mDropped.store(0, std::memory_order_relaxed);
+    ring->mRetired.store(false, std::memory_order_relaxed);
+
+    const std::lock_guard<std::mutex> lock(mLock);
+    mRings.push_back(ring);
+    return ring;
+}
+
+void ExtLogBackend::emit(const ExtLogEntry& entry) {
+    char line[EXT_LOG_LINE_MAX];
+    size_t len = 0;
+    uint8_t argIdx = 0;
+
+    for(const char* p = entry.mFmt; *p != '\0' && len < sizeof(line) - 1; p++) {
+        if(p[0] != '{' || p[1] != '}' || argIdx >= entry.mArgCount) {
+            line[len++] = *p;
+            continue;
+        }
+        p++;
+
+        int64_t v = entry.mArgs[argIdx];
+        size_t room = sizeof(line) - len;
+        int n = 0;
+        switch(entry.mArgTypes[argIdx]) {
+            case EXT_LOG_ARG_INT:
+                n = snprintf(line + len, room, "%lld", static_cast<long long>(v));
+                break;
+            case EXT_LOG_ARG_UINT:
+                n = snprintf(line + len, room, "%llu", static_cast<unsigned long long>(v));
+                break;
+            case EXT_LOG_ARG_HEX:
+                n = snprintf(line + len, room, "0x%llx", static_cast<unsigned long long>(v));
+                break;
+            case EXT_LOG_ARG_STR:
+                n = snprintf(line + len, room, "%s", entry.mStrBuf + v);
+                break;
+            case EXT_LOG_ARG_ERRNO: {
+                // Only this thread resolves errno strings.
+                const char* err = strerror(static_cast<int>(v));
+                n = snprintf(line + len, room, "%s", err ? err : "unknown");
+                break;
+            }
+            default:
+                break;
+        }
+        argIdx++;
+
+        if(n > 0) {
+            len += (static_cast<size_t>(n) < room) ? n : room - 1;
+        }
+    }
+    line[len] = '\0';
+
+    std::string msg(line, len);
+    switch(entry.mLevel) {
+        case EXT_LOG_LEVEL_DEBUG:
+            LOGD(entry.mTag, msg);
+            break;
+        case EXT_LOG_LEVEL_ERROR:
+            LOGE(entry.mTag, msg);
+            break;
+        default:
+            LOGI(entry.mTag, msg);
+            break;
+    }
+}
+
+void ExtLogBackend::drainRing(ExtLogRing* ring) {
+    uint32_t tail = ring->mTail.load(std::memory_order_relaxed);
+    uint32_t head = ring->mHead.load(std::memory_order_acquire);
+
+    while(tail != head) {
+        emit(ring->mEntries[tail & (EXT_LOG_RING_SIZE - 1)]);
+        tail++;
+        ring->mTail.store(tail, std::memory_order_release);
+    }
+
+    uint32_t dropped = ring->mDropped.exchange(0, std::memory_order_relaxed);
+    if(dropped > 0) {
+        LOGE("URM_EXT_LOG", "Log ring full, dropped " + std::to_string(dropped) + " records");
+    }
+}
+
+void ExtLogBackend::drainLoop() {
+    std::vector<ExtLogRing*> rings;
+    for(;;) {
+        bool stop = false;
+        {
+            std::unique_lock<std::mutex> lock(mLock);
+            mWake.wait_for(lock, std::chrono::milliseconds(EXT_LOG_DRAIN_MS),
+                           [this] { return mStop; });
+            stop = mStop;
+            rings = mRings;
+        }
+
+        std::vector<ExtLogRing*> retired;
+        for(ExtLogRing* ring : rings) {
+            // Check before draining so no record committed ahead of the
+            // retirement can be left behind.
+            bool isRetired = ring->mRetired.load(std::memory_order_acquire);
+            drainRing(ring);
+            if(isRetired) {
+                retired.push_back(ring);
+            }
+        }
+
+        if(!retired.empty()) {
+            const std::lock_guard<std::mutex> lock(mLock);
+            for(ExtLogRing* ring : retired) {
+                mRings.erase(std::remove(mRings.begin(), mRings.end(), ring), mRings.end());
+                delete ring;
+            }
+        }
+
+        if(stop) {
+            break;
+        }
+    }
+}
+
+ExtLogEntry* extLogBegin(uint8_t level, const char* tag, const char* fmt) {
+    if(gExtLogShutdown.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    ExtLogRing* ring = tRingOwner.mRing;
+    if(ring == nullptr) {
+        ring = ExtLogBackend::getInstance().registerRing();
+        tRingOwner.mRing = ring;
+    }
+
+    uint32_t head = ring->mHead.load(std::memory_order_relaxed);
+    uint32_t tail = ring->mTail.load(std::memory_order_acquire);
+    if(head - tail >= EXT_LOG_RING_SIZE) {
+        ring->mDropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    ExtLogEntry* e = &ring->mEntries[head & (EXT_LOG_RING_SIZE - 1)];
+    e->mTag = tag;
+    e->mFmt = fmt;
+    e->mLevel = level;
+    e->mArgCount = 0;
+    e->mStrLen = 0;
+    e->mStrBuf[EXT_LOG_STR_BUF - 1] = '\0';
+
+    tRingOwner.mPending = e;
+    return e;
+}
+
+void extLogCommit() {
+    ExtLogRing* ring = tRingOwner.mRing;
+    if(ring == nullptr || tRingOwner.mPending == nullptr) {
+        return;
+    }
+    tRingOwner.mPending = nullptr;
+    ring->mHead.store(ring->mHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
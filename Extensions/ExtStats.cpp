@@ -0,0 +1,66 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#include <mutex>
+#include <string>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Helpers.h"
+#include "ExtStats.h"
+#include "ExtLogger.h"
+
+std::atomic<uint64_t> gExtStats[STAT_COUNT];
+
+static const char* const kStatNames[STAT_COUNT] = {
+    "prewarm_jobs",
+    "prewarm_cancelled",
+    "prewarm_files",
+    "prewarm_bytes",
+    "prewarm_failed_bytes",
+    "prewarm_skipped_bytes",
+    "prewarm_last_us",
+    "reclaim_jobs",
+    "reclaim_timeouts",
+    "reclaim_bytes",
+    "reclaim_last_bytes",
+    "reclaim_last_us",
+};
+
+static std::mutex gStatsFileLock;
+
+void statsPublish() {
+    std::string text;
+    std::string line;
+    for(uint32_t i = 0; i < STAT_COUNT; i++) {
+        std::string value = std::to_string(gExtStats[i].load(std::memory_order_relaxed));
+        std::string field = std::string(kStatNames[i]) + "=" + value;
+        text += std::string(kStatNames[i]) + " " + value + "\n";
+
+        // Log records hold EXT_LOG_STR_BUF bytes of string arguments, so
+        // longer lists are split over several records.
+        if(!line.empty() && line.size() + 1 + field.size() >= EXT_LOG_STR_BUF) {
+            EXT_LOGI("URM_EXT_STATS", "{}", line);
+            line.clear();
+        }
+        line += (line.empty() ? "" : " ") + field;
+    }
+
+    EXT_LOGI("URM_EXT_STATS", "{}", line);
+
+    const char* path = std::getenv("URM_EXT_STATS_FILE");
+    if(path == nullptr || path[0] == '\0') {
+        return;
+    }
+
+    // Write a temporary file and rename it, readers never see a partial file.
+    const std::lock_guard<std::mutex> lock(gStatsFileLock);
+    const std::string tmpPath = std::string(path) + ".tmp";
+    if(writeLineToFile(tmpPath, text) == 0) {
+        if(rename(tmpPath.c_str(), path) != 0) {
+            TYPELOGV(ERRNO_LOG, strerror(errno));
+        }
+    }
+}
@@ -8,10 +8,116 @@
 #include <fstream>
 #include <sstream>
 #include <dirent.h>
+#include <climits>
 #include <algorithm>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "Helpers.h"
 #include "PredefCallbacks.h"
+#include "Tracing.h"
+#include "PageCachePrewarm.h"
+
+#define GENIE_CONFIG_MAX_BYTES (1 << 20)
+
+// Arguments of /proc/<pid>/cmdline, split on the NUL separators.
+static std::vector<std::string> readCmdlineArgs(pid_t pid) {
+    std::vector<std::string> args;
+    std::ifstream fileStream("/proc/" + std::to_string(pid) + "/cmdline", std::ios::in | std::ios::binary);
+    std::string arg;
+    while(fileStream.is_open() && std::getline(fileStream, arg, '\0')) {
+        args.push_back(arg);
+    }
+    return args;
+}
+
+static std::string readProcCwd(pid_t pid) {
+    char buf[PATH_MAX];
+    std::string link = "/proc/" + std::to_string(pid) + "/cwd";
+    ssize_t len = readlink(link.c_str(), buf, sizeof(buf) - 1);
+    if(len <= 0) {
+        return "";
+    }
+    return std::string(buf, len);
+}
+
+static bool isRegularFile(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+static std::string resolvePath(const std::string& path, const std::string& baseDir) {
+    if(path.empty() || path[0] == '/' || baseDir.empty()) {
+        return path;
+    }
+    return baseDir + "/" + path;
+}
+
+/**
+ * @brief Collect files referenced by the genie-t2t-run config (-c / --config).
+ *
+ * Every JSON string value naming an existing regular file is picked up, that
+ * covers the tokenizer, ctx-bins and backend extension configs without
+ * depending on the config schema. Relative paths are resolved against the
+ * process cwd first and the config directory second.
+ */
+static void collectModelFiles(pid_t pid, std::vector<std::string>& files) {
+    std::vector<std::string> args = readCmdlineArgs(pid);
+    std::string configArg;
+    for(size_t i = 1; i < args.size(); i++) {
+        if((args[i] == "-c" || args[i] == "--config") && i + 1 < args.size()) {
+            configArg = args[i + 1];
+            break;
+        }
+        if(args[i].compare(0, 9, "--config=") == 0) {
+            configArg = args[i].substr(9);
+            break;
+        }
+    }
+    if(configArg.empty()) {
+        return;
+    }
+
+    std::string cwd = readProcCwd(pid);
+    std::string configPath = resolvePath(configArg, cwd);
+    std::string configDir = configPath.substr(0, configPath.find_last_of('/'));
+
+    std::ifstream fileStream(configPath, std::ios::in);
+    if(!fileStream.is_open()) {
+        return;
+    }
+    std::string config(GENIE_CONFIG_MAX_BYTES, '\0');
+    fileStream.read(&config[0], config.size());
+    config.resize(fileStream.gcount());
+
+    size_t pos = 0;
+    while((pos = config.find('"', pos)) != std::string::npos) {
+        size_t end = pos + 1;
+        while(end < config.size() && config[end] != '"') {
+            end += (config[end] == '\\') ? 2 : 1;
+        }
+        if(end >= config.size()) {
+            break;
+        }
+
+        std::string value = config.substr(pos + 1, end - pos - 1);
+        pos = end + 1;
+        if(value.empty() || value.find('.') == std::string::npos) {
+            continue;
+        }
+
+        std::string path = resolvePath(value, cwd);
+        if(!isRegularFile(path)) {
+            path = resolvePath(value, configDir);
+            if(!isRegularFile(path)) {
+                continue;
+            }
+        }
+        if(std::find(files.begin(), files.end(), path) == files.end()) {
+            files.push_back(path);
+        }
+    }
+}
 
 static void workloadPostprocessCallback(void* context) {
     if(context == nullptr) {
@@ -23,9 +129,25 @@ static void workloadPostprocessCallback(void* context) {
         return;
     }
 
-    // Match to our usecase
-    cbData->mSigId = CONSTRUCT_SIG_CODE(0xf1, 0x0123);
-    cbData->mSigType = DEFAULT_SIGNAL_TYPE;
+    {
+        TraceScope scope(TRACE_EV_CLASSIFY, TRACE_CB_GENIE_POSTPROCESS, cbData->mSigId);
+
+        // Match to our usecase
+        cbData->mSigId = CONSTRUCT_SIG_CODE(0xf1, 0x0123);
+        cbData->mSigType = DEFAULT_SIGNAL_TYPE;
+
+        scope.mResCode = cbData->mSigId;
+        scope.mResult = cbData->mSigType;
+    }
+
+    // Model weights are page-faulted in during the first seconds of the
+    // run, start reading them while the process is still initialising.
+    // Parsing the config is left to the prewarm workers, URM acquires the
+    // signal as soon as this callback returns.
+    pid_t pid = cbData->mPid;
+    prewarmFiles(pid, [pid](std::vector<std::string>& files) {
+        collectModelFiles(pid, files);
+    });
 }
 
 URM_REGISTER_RES_APPLIER_CB(0x00f00001, getApplyCb(IRQ_AFFINE_ALL))
@@ -0,0 +1,349 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <iterator>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <sstream>
+#include <algorithm>
+#include <condition_variable>
+
+#include "Helpers.h"
+#include "Tracing.h"
+#include "ExtLogger.h"
+
+#define KGSL_DEFAULT_DIR        "/sys/class/kgsl/kgsl-3d0/"
+#define KGSL_BUSY_PERCENT_NODE  "gpu_busy_percentage"
+#define KGSL_GPUBUSY_NODE       "gpubusy"
+#define KGSL_AVAIL_FREQS_NODE   "devfreq/available_frequencies"
+#define KGSL_MIN_FREQ_NODE      "devfreq/min_freq"
+
+#define GPU_FLOOR_DEF_UP_PCT    80
+#define GPU_FLOOR_DEF_DOWN_PCT  40
+#define GPU_FLOOR_DEF_PERIOD_MS 100
+#define GPU_FLOOR_MIN_PERIOD_MS 20
+#define GPU_FLOOR_MAX_PERIOD_MS 1000
+#define GPU_FLOOR_DOWN_SAMPLES  3   // Consecutive idle samples before stepping down
+
+static constexpr const char* kLogTag = "URM_EXT_GPU_FLOOR";
+static constexpr uint32_t RES_CODE_KGSL_DYN_MIN_FREQ = 0x00810000;
+
+// Band requested through the resource Values:
+//   [floorMinHz, floorMaxHz, upPct, downPct, periodMs], the last three optional.
+typedef struct {
+    uint64_t mFloorMinHz;
+    uint64_t mFloorMaxHz;
+    uint32_t mUpPct;
+    uint32_t mDownPct;
+    uint32_t mPeriodMs;
+} GpuFloorBand;
+
+static bool sameBand(const GpuFloorBand& a, const GpuFloorBand& b) {
+    return a.mFloorMinHz == b.mFloorMinHz && a.mFloorMaxHz == b.mFloorMaxHz &&
+           a.mUpPct == b.mUpPct && a.mDownPct == b.mDownPct && a.mPeriodMs == b.mPeriodMs;
+}
+
+// Raises the devfreq floor one OPP while the GPU is busier than mUpPct and
+// lowers it again after GPU_FLOOR_DOWN_SAMPLES samples below mDownPct, never
+// leaving the requested band. Every holder of the resource adds its band,
+// the latest one still held is followed and min_freq is restored once the
+// last holder is torn.
+class GpuFloorController {
+private:
+    static std::once_flag mInitFlag;
+    static std::unique_ptr<GpuFloorController> mInstance;
+
+    // Serializes add / remove, including starting and joining mThread.
+    // Taken before mLock and never by the control loop.
+    std::mutex mControlLock;
+    std::vector<GpuFloorBand> mHolders;
+
+    std::mutex mLock;
+    std::condition_variable mWake;
+    std::thread mThread;
+    bool mRunning;
+    bool mStop;
+
+    std::string mKgslDir;
+    std::string mSavedMinFreq;
+    GpuFloorBand mBand;
+    std::vector<uint64_t> mLevels;      // Ascending OPPs inside the band
+    size_t mLevel;
+    uint32_t mIdleSamples;
+
+    int32_t readBusyPercent();
+    void    loadLevels();
+    void    writeFloor(size_t level);
+    void    controlLoop();
+    bool    start(const GpuFloorBand& band);
+    void    stop();
+
+    GpuFloorController();
+    GpuFloorController(const GpuFloorController&) = delete;
+    GpuFloorController& operator=(const GpuFloorController&) = delete;
+
+public:
+    static GpuFloorController& getInstance() {
+        std::call_once(mInitFlag, [] {
+            mInstance.reset(new GpuFloorController());
+        });
+        return *mInstance;
+    }
+
+    ~GpuFloorController() {
+        const std::lock_guard<std::mutex> control(mControlLock);
+        mHolders.clear();
+        stop();
+    }
+
+    void addHolder(const GpuFloorBand& band);
+    void removeHolder(const GpuFloorBand& band);
+};
+
+std::once_flag GpuFloorController::mInitFlag;
+std::unique_ptr<GpuFloorController> GpuFloorController::mInstance = nullptr;
+
+GpuFloorController::GpuFloorController()
+    : mRunning(false), mStop(false), mLevel(0), mIdleSamples(0) {
+    // Lets the loop run against a fake kgsl tree off-device.
+    const char* dir = std::getenv("URM_EXT_KGSL_DIR");
+    mKgslDir = (dir != nullptr && dir[0] != '\0') ? dir : KGSL_DEFAULT_DIR;
+    if(mKgslDir.back() != '/') {
+        mKgslDir.push_back('/');
+    }
+    mBand = {0, 0, GPU_FLOOR_DEF_UP_PCT, GPU_FLOOR_DEF_DOWN_PCT, GPU_FLOOR_DEF_PERIOD_MS};
+}
+
+/**
+ * @brief Current GPU load in percent, -1 if neither kgsl node is readable.
+ *
+ * gpu_busy_percentage reads as "NN %", gpubusy as "<busy> <total>" for the
+ * last sampling window.
+ */
+int32_t GpuFloorController::readBusyPercent() {
+    std::string line;
+    if(readLineFromFile(mKgslDir + KGSL_BUSY_PERCENT_NODE, line)) {
+        char* end = nullptr;
+        long pct = strtol(line.c_str(), &end, 10);
+        if(end != line.c_str()) {
+            return static_cast<int32_t>(std::min(std::max(pct, 0L), 100L));
+        }
+    }
+
+    if(readLineFromFile(mKgslDir + KGSL_GPUBUSY_NODE, line)) {
+        std::istringstream iss(line);
+        uint64_t busy = 0, total = 0;
+        if(iss >> busy >> total) {
+            if(total == 0) return 0;
+            return static_cast<int32_t>(std::min<uint64_t>(busy * 100 / total, 100));
+        }
+    }
+
+    return -1;
+}
+
+void GpuFloorController::loadLevels() {
+    mLevels.clear();
+
+    std::string line;
+    if(readLineFromFile(mKgslDir + KGSL_AVAIL_FREQS_NODE, line)) {
+        std::istringstream iss(line);
+        uint64_t freq = 0;
+        while(iss >> freq) {
+            if(freq >= mBand.mFloorMinHz && freq <= mBand.mFloorMaxHz) {
+                mLevels.push_back(freq);
+            }
+        }
+    }
+
+    // No OPP table or none inside the band, step between the band edges.
+    if(mLevels.empty()) {
+        mLevels.push_back(mBand.mFloorMinHz);
+        if(mBand.mFloorMaxHz != mBand.mFloorMinHz) {
+            mLevels.push_back(mBand.mFloorMaxHz);
+        }
+    }
+
+    std::sort(mLevels.begin(), mLevels.end());
+    mLevels.erase(std::unique(mLevels.begin(), mLevels.end()), mLevels.end());
+}
+
+void GpuFloorController::writeFloor(size_t level) {
+    mLevel = level;
+    const std::string node = mKgslDir + KGSL_MIN_FREQ_NODE;
+    int rc = traceWriteLineToFile(TRACE_CB_GPU_FLOOR, RES_CODE_KGSL_DYN_MIN_FREQ,
+                                  node, std::to_string(mLevels[level]));
+    if(rc != 0) {
+        EXT_LOGE(kLogTag, "write failed for {}: {}", node, ExtErrno{rc});
+    }
+}
+
+void GpuFloorController::controlLoop() {
+    std::unique_lock<std::mutex> lock(mLock);
+    while(!mStop) {
+        mWake.wait_for(lock, std::chrono::milliseconds(mBand.mPeriodMs), [this] { return mStop; });
+        if(mStop) break;
+
+        int32_t busy = readBusyPercent();
+        if(busy < 0) continue;
+
+        if(static_cast<uint32_t>(busy) >= mBand.mUpPct) {
+            mIdleSamples = 0;
+            if(mLevel + 1 < mLevels.size()) {
+                writeFloor(mLevel + 1);
+                EXT_LOGD(kLogTag, "busy={} floor up to {}", busy, mLevels[mLevel]);
+            }
+        } else if(static_cast<uint32_t>(busy) <= mBand.mDownPct) {
+            // Single idle frames are common between submissions, only back
+            // off once the GPU stays idle.
+            if(++mIdleSamples >= GPU_FLOOR_DOWN_SAMPLES && mLevel > 0) {
+                mIdleSamples = 0;
+                writeFloor(mLevel - 1);
+                EXT_LOGD(kLogTag, "busy={} floor down to {}", busy, mLevels[mLevel]);
+            }
+        } else {
+            mIdleSamples = 0;
+        }
+    }
+}
+
+// Called with mControlLock held. Returns false if min_freq is unusable.
+bool GpuFloorController::start(const GpuFloorBand& band) {
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        bool wasRunning = mRunning;
+
+        if(!wasRunning) {
+            const std::string node = mKgslDir + KGSL_MIN_FREQ_NODE;
+            if(!readLineFromFile(node, mSavedMinFreq)) {
+                EXT_LOGE(kLogTag, "{} not readable, controller not started", node);
+                return false;
+            }
+            mSavedMinFreq = trim(mSavedMinFreq);
+        }
+
+        // A different band restarts the floor from its lower edge.
+        mBand = band;
+        loadLevels();
+        mIdleSamples = 0;
+        writeFloor(0);
+
+        EXT_LOGI(kLogTag, "band {}..{} Hz, {} levels, up={}% down={}% period={}ms",
+                 mBand.mFloorMinHz, mBand.mFloorMaxHz, mLevels.size(),
+                 mBand.mUpPct, mBand.mDownPct, mBand.mPeriodMs);
+
+        if(wasRunning) {
+            return true;
+        }
+        mRunning = true;
+        mStop = false;
+    }
+    mThread = std::thread(&GpuFloorController::controlLoop, this);
+    return true;
+}
+
+// Called with mControlLock held, so no start() can race the join below.
+void GpuFloorController::stop() {
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        if(!mRunning) return;
+        mStop = true;
+    }
+    mWake.notify_one();
+    if(mThread.joinable()) {
+        mThread.join();
+    }
+
+    const std::lock_guard<std::mutex> lock(mLock);
+    const std::string node = mKgslDir + KGSL_MIN_FREQ_NODE;
+    TYPELOGV(NOTIFY_NODE_RESET, node.c_str(), mSavedMinFreq.c_str());
+    traceWriteLineToFile(TRACE_CB_GPU_FLOOR, RES_CODE_KGSL_DYN_MIN_FREQ, node, mSavedMinFreq);
+    mRunning = false;
+}
+
+void GpuFloorController::addHolder(const GpuFloorBand& band) {
+    const std::lock_guard<std::mutex> control(mControlLock);
+    if(start(band)) {
+        mHolders.push_back(band);
+    }
+}
+
+/**
+ * @brief Drop one holder of band. The controller keeps running with the
+ *        latest remaining band and only stops with the last holder.
+ */
+void GpuFloorController::removeHolder(const GpuFloorBand& band) {
+    const std::lock_guard<std::mutex> control(mControlLock);
+
+    auto it = std::find_if(mHolders.rbegin(), mHolders.rend(),
+                           [&band](const GpuFloorBand& held) { return sameBand(held, band); });
+    if(it == mHolders.rend()) {
+        return;
+    }
+    bool wasActive = (it == mHolders.rbegin());
+    mHolders.erase(std::next(it).base());
+
+    if(mHolders.empty()) {
+        stop();
+    } else if(wasActive && !sameBand(mHolders.back(), band)) {
+        start(mHolders.back());
+    }
+}
+
+// Values: [floorMinHz, floorMaxHz, upPct, downPct, periodMs], the last three
+// optional. Applier and tear both parse them, the tear to find its holder.
+static bool parseBand(Resource* resource, GpuFloorBand& band) {
+    int32_t count = resource->getValuesCount();
+    if(count < 2) {
+        EXT_LOGE(kLogTag, "expected at least [floorMinHz, floorMaxHz], got {} values", count);
+        return false;
+    }
+
+    band = {0, 0, GPU_FLOOR_DEF_UP_PCT, GPU_FLOOR_DEF_DOWN_PCT, GPU_FLOOR_DEF_PERIOD_MS};
+    band.mFloorMinHz = static_cast<uint32_t>(resource->getValueAt(0));
+    band.mFloorMaxHz = static_cast<uint32_t>(resource->getValueAt(1));
+    if(count > 2) band.mUpPct = static_cast<uint32_t>(resource->getValueAt(2));
+    if(count > 3) band.mDownPct = static_cast<uint32_t>(resource->getValueAt(3));
+    if(count > 4) band.mPeriodMs = static_cast<uint32_t>(resource->getValueAt(4));
+
+    if(band.mFloorMaxHz < band.mFloorMinHz) {
+        std::swap(band.mFloorMinHz, band.mFloorMaxHz);
+    }
+    band.mUpPct = std::min<uint32_t>(band.mUpPct, 100);
+    band.mDownPct = std::min(band.mDownPct, band.mUpPct);
+    band.mPeriodMs = std::min<uint32_t>(std::max<uint32_t>(band.mPeriodMs, GPU_FLOOR_MIN_PERIOD_MS),
+                                        GPU_FLOOR_MAX_PERIOD_MS);
+    return true;
+}
+
+static void gpuFloorApplierCallback(void* context) {
+    if(context == nullptr) return;
+    Resource* resource = static_cast<Resource*>(context);
+    TraceScope scope(TRACE_EV_APPLY, TRACE_CB_GPU_FLOOR, RES_CODE_KGSL_DYN_MIN_FREQ);
+
+    GpuFloorBand band;
+    if(!parseBand(resource, band)) {
+        scope.mResult = -1;
+        return;
+    }
+    GpuFloorController::getInstance().addHolder(band);
+}
+
+static void gpuFloorTearCallback(void* context) {
+    if(context == nullptr) return;
+    Resource* resource = static_cast<Resource*>(context);
+    TraceScope scope(TRACE_EV_TEAR, TRACE_CB_GPU_FLOOR, RES_CODE_KGSL_DYN_MIN_FREQ);
+
+    GpuFloorBand band;
+    if(parseBand(resource, band)) {
+        GpuFloorController::getInstance().removeHolder(band);
+    }
+}
+
+URM_REGISTER_RES_APPLIER_CB(0x00810000, gpuFloorApplierCallback)
+URM_REGISTER_RES_TEAR_CB   (0x00810000, gpuFloorTearCallback)
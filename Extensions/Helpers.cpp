@@ -7,6 +7,8 @@
 #include <unistd.h>
 #include <cerrno>
 #include <cctype>
+#include <cstdlib>
+#include <strings.h>
 
 #include "Helpers.h"
 
@@ -32,6 +34,13 @@ std::string trim(const std::string& s) {
     return s.substr(b, e - b);
 }
 
+bool parseBoolEnv(const char* v) {
+    if (!v) return false;
+    return (!strcasecmp(v, "1") || !strcasecmp(v, "true") ||
+            !strcasecmp(v, "on") || !strcasecmp(v, "yes") ||
+            !strcasecmp(v, "y"));
+}
+
 // Check writability using access(2)
 bool isWritable(const std::string& path) {
     if (path.empty()) return false;
@@ -79,6 +88,26 @@ bool readLineFromFile(const std::string& fileName, std::string& line) {
     return true;
 }
 
+// A /proc/meminfo field in bytes, 0 if missing.
+static uint64_t readMemInfoBytes(const std::string& field) {
+    std::ifstream fileStream("/proc/meminfo", std::ios::in);
+    std::string line;
+    while(getline(fileStream, line)) {
+        if(line.compare(0, field.size(), field) == 0) {
+            return strtoull(line.c_str() + field.size(), nullptr, 10) * 1024;
+        }
+    }
+    return 0;
+}
+
+uint64_t readMemAvailable() {
+    return readMemInfoBytes("MemAvailable:");
+}
+
+uint64_t readMemFree() {
+    return readMemInfoBytes("MemFree:");
+}
+
 void fetchMachineName(std::string& machineName) {
     std::string machineNamePath = "/sys/devices/soc0/machine";
     std::string v;
@@ -90,3 +119,51 @@ void fetchMachineName(std::string& machineName) {
     toLower(v);
     machineName = v;
 }
+
+std::string stripQuotes(const std::string& s) {
+    std::string v = trim(s);
+    if(v.size() >= 2 && (v.front() == '"' || v.front() == '\'') && v.back() == v.front()) {
+        return v.substr(1, v.size() - 2);
+    }
+    return v;
+}
+
+// Extract the value of `key` from a flow-style mapping such as
+// {ResCode: "RES_X", ResInfo: "0x0", Values: [1, 2]}
+std::string flowField(const std::string& line, const std::string& key) {
+    size_t pos = line.find(key + ":");
+    if(pos == std::string::npos) {
+        return "";
+    }
+    pos = line.find_first_not_of(' ', pos + key.size() + 1);
+    if(pos == std::string::npos) {
+        return "";
+    }
+
+    size_t end = std::string::npos;
+    if(line[pos] == '[') {
+        end = line.find(']', pos);
+        if(end != std::string::npos) end++;
+    } else {
+        end = line.find_first_of(",}", pos);
+    }
+
+    return stripQuotes(line.substr(pos, end == std::string::npos ? std::string::npos : end - pos));
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::string inner = trim(list);
+    if(!inner.empty() && inner.front() == '[') inner.erase(0, 1);
+    if(!inner.empty() && inner.back() == ']') inner.pop_back();
+
+    std::string item;
+    std::istringstream iss(inner);
+    while(std::getline(iss, item, ',')) {
+        item = stripQuotes(item);
+        if(!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
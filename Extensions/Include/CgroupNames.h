@@ -0,0 +1,25 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_EXT_CGROUP_NAMES_H
+#define URM_EXT_CGROUP_NAMES_H
+
+#include <string>
+#include <cstdint>
+
+#define CGROUP_V2_ROOT "/sys/fs/cgroup/"
+
+/**
+ * @brief Resolve a URM cgroup identifier to its cgroup v2 directory.
+ *
+ * Identifiers are the ones used as the first value of RES_CGRP_* resources.
+ * Names come from the CgroupsInfo section of the URM core InitConfig.yaml,
+ * overridden by /etc/urm/target/InitConfig.yaml and the target directory,
+ * parsed once on first use.
+ *
+ * @return true if the identifier is known, path then holds the directory
+ *         with a trailing '/'.
+ */
+bool getCgroupPath(int32_t cgroupId, std::string& path);
+
+#endif
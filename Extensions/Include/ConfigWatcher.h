@@ -0,0 +1,30 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_EXT_CONFIG_WATCHER_H
+#define URM_EXT_CONFIG_WATCHER_H
+
+#include <string>
+#include <functional>
+
+typedef std::function<void()> ConfigReloadCallback;
+
+/**
+ * @brief Invoke onChange whenever fileName is written, replaced or removed
+ *        in /etc/urm/target/ or the directory of the current target.
+ *
+ * Directories are watched through inotify by a single thread, started on the
+ * first registration. Events are batched until the directories stay quiet
+ * for a short while, so an editor saving in several steps triggers one
+ * reload. Callbacks run on the watcher thread, at most once per batch, and
+ * must re-read both the generic and the target file themselves.
+ *
+ * Used for IrqThreadConfig.yaml. Files URM core parses must not be
+ * registered, the core reads them once at start. A target directory that
+ * is missing at registration is picked up once it is created.
+ *
+ * Only active with URM_EXT_CONFIG_WATCH=1, registration is a no-op otherwise.
+ */
+void watchConfigFile(const std::string& fileName, const ConfigReloadCallback& onChange);
+
+#endif
@@ -0,0 +1,127 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_EXT_LOGGER_H
+#define URM_EXT_LOGGER_H
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+#define EXT_LOG_LEVEL_DEBUG 0
+#define EXT_LOG_LEVEL_INFO  1
+#define EXT_LOG_LEVEL_ERROR 2
+#define EXT_LOG_LEVEL_NONE  3
+
+// Levels below this threshold are compiled out, set via -DURM_EXT_LOG_LEVEL.
+// Disabled macros keep their arguments type-checked but never evaluate them.
+#ifndef URM_EXT_LOG_LEVEL
+#define URM_EXT_LOG_LEVEL EXT_LOG_LEVEL_INFO
+#endif
+
+#define EXT_LOG_MAX_ARGS    6
+#define EXT_LOG_STR_BUF     160
+
+enum ExtLogArgType : uint8_t {
+    EXT_LOG_ARG_INT = 0,
+    EXT_LOG_ARG_UINT,
+    EXT_LOG_ARG_HEX,
+    EXT_LOG_ARG_STR,
+    EXT_LOG_ARG_ERRNO,
+};
+
+// Binary log record. Strings are copied into mStrBuf so the record does
+// not reference caller memory once queued, everything else stays binary
+// until the drain thread formats it.
+typedef struct {
+    const char* mTag;
+    const char* mFmt;       // Static format string, "{}" marks an argument
+    uint8_t     mLevel;
+    uint8_t     mArgCount;
+    uint8_t     mArgTypes[EXT_LOG_MAX_ARGS];
+    int64_t     mArgs[EXT_LOG_MAX_ARGS];   // Value, or offset into mStrBuf for strings
+    uint16_t    mStrLen;
+    char        mStrBuf[EXT_LOG_STR_BUF];
+} ExtLogEntry;
+
+// Wrappers to select how an integer argument is rendered.
+typedef struct { uint64_t mValue; } ExtHex;
+typedef struct { int32_t mValue; } ExtErrno;
+
+inline void extLogPackArg(ExtLogEntry& e, ExtLogArgType type, int64_t value) {
+    if(e.mArgCount >= EXT_LOG_MAX_ARGS) return;
+    e.mArgTypes[e.mArgCount] = type;
+    e.mArgs[e.mArgCount] = value;
+    e.mArgCount++;
+}
+
+inline void extLogPackArg(ExtLogEntry& e, const char* s, size_t len) {
+    if(e.mArgCount >= EXT_LOG_MAX_ARGS) return;
+
+    // The last byte of mStrBuf is kept '\0' and backs arguments which no
+    // longer fit, longer strings are truncated.
+    size_t offset = e.mStrLen;
+    size_t room = EXT_LOG_STR_BUF - 1 - offset;
+    if(room == 0) {
+        offset = EXT_LOG_STR_BUF - 1;
+    } else {
+        if(len >= room) {
+            len = room - 1;
+        }
+        memcpy(e.mStrBuf + offset, s, len);
+        e.mStrBuf[offset + len] = '\0';
+        e.mStrLen = static_cast<uint16_t>(offset + len + 1);
+    }
+
+    e.mArgTypes[e.mArgCount] = EXT_LOG_ARG_STR;
+    e.mArgs[e.mArgCount] = static_cast<int64_t>(offset);
+    e.mArgCount++;
+}
+
+inline void extLogPack(ExtLogEntry& e, int32_t v)  { extLogPackArg(e, EXT_LOG_ARG_INT, v); }
+inline void extLogPack(ExtLogEntry& e, int64_t v)  { extLogPackArg(e, EXT_LOG_ARG_INT, v); }
+inline void extLogPack(ExtLogEntry& e, uint32_t v) { extLogPackArg(e, EXT_LOG_ARG_UINT, v); }
+inline void extLogPack(ExtLogEntry& e, uint64_t v) { extLogPackArg(e, EXT_LOG_ARG_UINT, static_cast<int64_t>(v)); }
+inline void extLogPack(ExtLogEntry& e, ExtHex v)   { extLogPackArg(e, EXT_LOG_ARG_HEX, static_cast<int64_t>(v.mValue)); }
+inline void extLogPack(ExtLogEntry& e, ExtErrno v) { extLogPackArg(e, EXT_LOG_ARG_ERRNO, v.mValue); }
+inline void extLogPack(ExtLogEntry& e, const char* s) { extLogPackArg(e, s ? s : "", s ? strlen(s) : 0); }
+inline void extLogPack(ExtLogEntry& e, const std::string& s) { extLogPackArg(e, s.data(), s.size()); }
+
+ExtLogEntry* extLogBegin(uint8_t level, const char* tag, const char* fmt);
+void         extLogCommit();
+
+/**
+ * @brief Queue a log record on the calling thread's ring.
+ *
+ * Never blocks and never allocates after the first call on a thread. If the
+ * ring is full the record is dropped and counted. A background thread
+ * formats queued records and hands them to the URM Logger.
+ */
+template<typename... Args>
+inline void extLogRecord(uint8_t level, const char* tag, const char* fmt, const Args&... args) {
+    ExtLogEntry* e = extLogBegin(level, tag, fmt);
+    if(e == nullptr) return;
+    int unpack[] = {0, (extLogPack(*e, args), 0)...};
+    (void)unpack;
+    extLogCommit();
+}
+
+#if URM_EXT_LOG_LEVEL <= EXT_LOG_LEVEL_DEBUG
+#define EXT_LOGD(tag, ...) extLogRecord(EXT_LOG_LEVEL_DEBUG, tag, __VA_ARGS__)
+#else
+#define EXT_LOGD(tag, ...) do { if(false) extLogRecord(EXT_LOG_LEVEL_DEBUG, tag, __VA_ARGS__); } while(0)
+#endif
+
+#if URM_EXT_LOG_LEVEL <= EXT_LOG_LEVEL_INFO
+#define EXT_LOGI(tag, ...) extLogRecord(EXT_LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#else
+#define EXT_LOGI(tag, ...) do { if(false) extLogRecord(EXT_LOG_LEVEL_INFO, tag, __VA_ARGS__); } while(0)
+#endif
+
+#if URM_EXT_LOG_LEVEL <= EXT_LOG_LEVEL_ERROR
+#define EXT_LOGE(tag, ...) extLogRecord(EXT_LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+#else
+#define EXT_LOGE(tag, ...) do { if(false) extLogRecord(EXT_LOG_LEVEL_ERROR, tag, __VA_ARGS__); } while(0)
+#endif
+
+#endif
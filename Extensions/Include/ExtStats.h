@@ -0,0 +1,48 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_EXT_STATS_H
+#define URM_EXT_STATS_H
+
+#include <atomic>
+#include <cstdint>
+
+// Plugin wide counters. Add new ids before STAT_COUNT and a matching name
+// in ExtStats.cpp.
+enum ExtStatId : uint32_t {
+    STAT_PREWARM_JOBS = 0,      // Prewarm jobs started
+    STAT_PREWARM_CANCELLED,     // Jobs stopped early because the process exited
+    STAT_PREWARM_FILES,         // Files submitted for readahead
+    STAT_PREWARM_BYTES,         // Bytes the kernel accepted for readahead
+    STAT_PREWARM_FAILED_BYTES,  // Bytes both readahead and fadvise refused
+    STAT_PREWARM_SKIPPED_BYTES, // Bytes left out to stay within available memory
+    STAT_PREWARM_LAST_US,       // Duration of the last completed job
+    STAT_RECLAIM_JOBS,          // Proactive reclaim jobs run
+    STAT_RECLAIM_TIMEOUTS,      // Jobs which hit their time budget before the target
+    STAT_RECLAIM_BYTES,         // Bytes reclaimed over all jobs
+    STAT_RECLAIM_LAST_BYTES,    // Bytes reclaimed by the last job
+    STAT_RECLAIM_LAST_US,       // Duration of the last job
+    STAT_COUNT,
+};
+
+extern std::atomic<uint64_t> gExtStats[STAT_COUNT];
+
+inline void statAdd(ExtStatId id, uint64_t value) {
+    gExtStats[id].fetch_add(value, std::memory_order_relaxed);
+}
+
+inline void statSet(ExtStatId id, uint64_t value) {
+    gExtStats[id].store(value, std::memory_order_relaxed);
+}
+
+inline uint64_t statGet(ExtStatId id) {
+    return gExtStats[id].load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Log all counters and, if URM_EXT_STATS_FILE is set, rewrite that
+ *        file with one "name value" line per counter.
+ */
+void statsPublish();
+
+#endif
@@ -5,6 +5,8 @@
 #define URM_EXT_HELPERS_H
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
 #include <Urm/Logger.h>
 #include <Urm/Resource.h>
@@ -14,12 +16,22 @@
 #include <Urm/TargetRegistry.h>
 #include <Urm/ResourceRegistry.h>
 
+#define URM_TARGET_CONFIG_DIR "/etc/urm/target/"
+
 std::string trim(const std::string& s);
 void toLower(std::string& s);
+bool parseBoolEnv(const char* v);
 bool isWritable(const std::string& path);
 int writeLineToFile(const std::string& fileName, const std::string& value);
 bool readLineFromFile(const std::string& fileName, std::string& line);
+uint64_t readMemAvailable();    // MemAvailable in bytes, 0 if unknown
+uint64_t readMemFree();         // MemFree in bytes, 0 if unknown
 void fetchMachineName(std::string& machineName);
 std::string cpuMaskToHex(uint64_t mask);
 
+// Minimal helpers for the line based YAML parsing done by the plugin.
+std::string stripQuotes(const std::string& s);
+std::string flowField(const std::string& line, const std::string& key);
+std::vector<std::string> splitList(const std::string& list);
+
 #endif
@@ -0,0 +1,42 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_EXT_IRQ_AFFINITY_H
+#define URM_EXT_IRQ_AFFINITY_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+/**
+ * @brief Arbitrate /proc/irq/<n>/smp_affinity between plugin resources.
+ *
+ * RES_IRQ_AFFINE_ALL (PredefCallbacks.cpp) and RES_IRQ_AFFINITY
+ * (PreemptRtExtn.cpp) both rewrite every IRQ. Holders are keyed by resource
+ * code; the most recent holder's mask is the one in effect. The value found
+ * before the first holder is kept until the last holder releases.
+ *
+ * Callers do the file writes themselves so they keep their own tracing.
+ */
+
+/**
+ * @brief Record the mask an owner wants for one IRQ.
+ *
+ * @param curVal Current file content, saved only if no one holds the IRQ.
+ */
+void holdIrqAffinity(uint32_t owner, const std::string& path,
+                     const std::string& curVal, const std::string& mask);
+
+/**
+ * @brief Drop an owner from every IRQ it holds.
+ *
+ * @param writes Receives the path/value pairs to write back: the mask of the
+ *               latest remaining holder, or the saved original value when
+ *               none is left. IRQs where the owner was not in effect are
+ *               left out.
+ */
+void releaseIrqAffinity(uint32_t owner,
+                        std::vector<std::pair<std::string, std::string>>& writes);
+
+#endif
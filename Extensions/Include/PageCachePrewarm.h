@@ -0,0 +1,30 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_EXT_PAGE_CACHE_PREWARM_H
+#define URM_EXT_PAGE_CACHE_PREWARM_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <sys/types.h>
+
+// Fills in the files to prewarm, runs on a prewarm worker.
+typedef std::function<void(std::vector<std::string>& files)> PrewarmFileCollector;
+
+/**
+ * @brief Pull the files named by collect into the page cache on behalf of pid.
+ *
+ * collect runs on the worker pool rather than the caller, so a post-process
+ * callback returns before any config is read or path is stat'ed. The files
+ * are then split into chunks which the same workers hand to
+ * readahead(2), falling back to posix_fadvise(WILLNEED). Files which do not
+ * fit into half of MemAvailable (remaining after earlier files) are
+ * skipped. Outstanding chunks are dropped once pid exits. Progress is
+ * reported through the STAT_PREWARM_* counters.
+ *
+ * Returns immediately, disabled by setting URM_EXT_PREWARM=0.
+ */
+void prewarmFiles(pid_t pid, const PrewarmFileCollector& collect);
+
+#endif
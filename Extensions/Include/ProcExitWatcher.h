@@ -0,0 +1,28 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_EXT_PROC_EXIT_WATCHER_H
+#define URM_EXT_PROC_EXIT_WATCHER_H
+
+#include <functional>
+#include <sys/types.h>
+
+typedef std::function<void(pid_t)> ProcExitCallback;
+
+/**
+ * @brief Invoke onExit once the process pid exits.
+ *
+ * Exits are detected through a pidfd per watched process, polled by a single
+ * epoll thread shared by all extension modules. Several callbacks can be
+ * registered for the same pid, they run on the watcher thread in
+ * registration order and must not block: a slow callback delays the exit
+ * of every other watched process. Work that calls into URM (acquire or
+ * release a signal) belongs on a thread of the caller's own.
+ *
+ * @return 0 on success.
+ *         ESRCH if the process is already gone, the callback is not invoked.
+ *         Any other errno if pidfds are unavailable (kernels before 5.3).
+ */
+int watchProcessExit(pid_t pid, const ProcExitCallback& onExit);
+
+#endif
@@ -0,0 +1,38 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_EXT_SIGNAL_TIERS_H
+#define URM_EXT_SIGNAL_TIERS_H
+
+#include <string>
+#include <sys/types.h>
+
+#include "Helpers.h"
+
+/**
+ * @brief Map a computed SigType onto a tier the current target defines.
+ *
+ * @return sigType if it is defined or the signal has no tiers for this
+ *         target, otherwise the highest defined tier below it (the lowest
+ *         defined tier if there is none below).
+ */
+uint32_t resolveSignalTier(uint32_t sigCode, uint32_t sigType);
+
+/**
+ * @brief Move an active signal from one tier to another.
+ *
+ * URM only takes whole signals. Tiers configuring the exact same nodes and
+ * values keep the existing handle. Otherwise the whole target tier is
+ * acquired before the source tier is released: every node of the target
+ * tier is written, but no node falls back to its default in between.
+ *
+ * @return Handle which is now active, the original one if the switch failed.
+ */
+int64_t transitionSignal(int64_t handle,
+                         uint32_t sigCode,
+                         uint32_t fromType,
+                         uint32_t toType,
+                         pid_t pid,
+                         uint32_t* extraArgs);
+
+#endif
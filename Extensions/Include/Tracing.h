@@ -0,0 +1,137 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_EXT_TRACING_H
+#define URM_EXT_TRACING_H
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+#ifdef URM_EXT_HAVE_SDT
+// Probes get a semaphore which tracers bump while attached, so argument
+// setup for the probe is skipped when nobody is listening.
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+extern "C" unsigned short urm_ext_event_semaphore;
+#define URM_EXT_PROBE_ACTIVE() __builtin_expect(urm_ext_event_semaphore != 0, 0)
+#else
+#define URM_EXT_PROBE_ACTIVE() false
+#endif
+
+// What happened, emitted as "ev=" in trace_marker lines.
+enum TraceEventKind : uint32_t {
+    TRACE_EV_APPLY = 0,     // Resource applier callback finished
+    TRACE_EV_TEAR,          // Resource tear callback finished
+    TRACE_EV_NODE_WRITE,    // Single sysfs / procfs node written
+    TRACE_EV_CLASSIFY,      // Post-process classification finished
+    TRACE_EV_ACQUIRE,       // acquireSignal() returned
+    TRACE_EV_RELEASE,       // releaseSignal() returned
+    TRACE_EV_PREWARM,       // Page cache prewarm job finished, ret is bytes read
+    TRACE_EV_RECLAIM,       // Proactive reclaim job finished, ret is bytes reclaimed
+    TRACE_EV_COUNT,
+};
+
+// Which callback emitted the event, emitted as "cb=".
+enum TraceCallbackId : uint32_t {
+    TRACE_CB_CPUFREQ_GOV = 0,
+    TRACE_CB_IRQ_AFFINITY,
+    TRACE_CB_WQ_AFFINITY,
+    TRACE_CB_IRQ_AFFINE_ALL,
+    TRACE_CB_CAM_POSTPROCESS,
+    TRACE_CB_GENIE_POSTPROCESS,
+    TRACE_CB_TIER_TRANSITION,
+    TRACE_CB_GPU_FLOOR,
+    TRACE_CB_IO_QOS,
+    TRACE_CB_PREWARM,
+    TRACE_CB_IRQ_THREAD_PRIO,
+    TRACE_CB_MEM_RECLAIM,
+};
+
+extern std::atomic<bool> gTraceMarkerEnabled;
+
+/**
+ * @brief Whether events are written to the ftrace trace_marker.
+ *
+ * Controlled through the URM_EXT_TRACE env var, read once when the plugin
+ * is loaded. USDT probes are compiled in when sys/sdt.h is available and
+ * only fire while a tracer is attached.
+ */
+inline bool isTraceMarkerEnabled() {
+    return gTraceMarkerEnabled.load(std::memory_order_relaxed);
+}
+
+inline bool isTracingActive() {
+    return isTraceMarkerEnabled() || URM_EXT_PROBE_ACTIVE();
+}
+
+uint64_t traceNowNs();
+uint32_t traceNodeId(const std::string& path);
+void     traceMarkerWrite(uint32_t kind, uint32_t cbId, uint32_t resCode,
+                          uint32_t nodeId, uint64_t durationNs, int64_t result);
+
+/**
+ * @brief Emit one tuning event to USDT and, if enabled, to trace_marker.
+ *
+ * @param kind       TraceEventKind
+ * @param cbId       TraceCallbackId
+ * @param resCode    Resource code, or signal code for post-process / signal events
+ * @param nodeId     Node path id from traceNodeId(), 0 if not node specific
+ * @param durationNs Time spent in the action
+ * @param result     Return code, handle or selected SigType
+ */
+inline void traceEvent(uint32_t kind, uint32_t cbId, uint32_t resCode,
+                       uint32_t nodeId, uint64_t durationNs, int64_t result) {
+#ifdef URM_EXT_HAVE_SDT
+    if(URM_EXT_PROBE_ACTIVE()) {
+        STAP_PROBE6(urm_ext, event, kind, cbId, resCode, nodeId, durationNs, result);
+    }
+#endif
+    if(isTraceMarkerEnabled()) {
+        traceMarkerWrite(kind, cbId, resCode, nodeId, durationNs, result);
+    }
+}
+
+// Times a scope and emits a single event for it on exit. Nothing is read or
+// emitted unless trace_marker output is enabled or a USDT probe is attached.
+class TraceScope {
+private:
+    uint32_t mKind;
+    uint32_t mCbId;
+    uint32_t mNodeId;
+    uint64_t mStartNs;
+
+public:
+    uint32_t mResCode;
+    int64_t mResult;
+
+    TraceScope(uint32_t kind, uint32_t cbId, uint32_t resCode)
+        : mKind(kind), mCbId(cbId), mNodeId(0), mStartNs(0), mResCode(resCode), mResult(0) {
+        if(isTracingActive()) {
+            mStartNs = traceNowNs();
+        }
+    }
+
+    TraceScope(uint32_t kind, uint32_t cbId, uint32_t resCode, const std::string& nodePath)
+        : TraceScope(kind, cbId, resCode) {
+        if(mStartNs != 0) {
+            mNodeId = traceNodeId(nodePath);
+        }
+    }
+
+    ~TraceScope() {
+        if(mStartNs == 0) return;
+        traceEvent(mKind, mCbId, mResCode, mNodeId, traceNowNs() - mStartNs, mResult);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+/**
+ * @brief writeLineToFile() which also emits a TRACE_EV_NODE_WRITE event.
+ */
+int traceWriteLineToFile(uint32_t cbId, uint32_t resCode,
+                         const std::string& path, const std::string& value);
+
+#endif
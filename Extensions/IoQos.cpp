@@ -0,0 +1,362 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <iterator>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include "Helpers.h"
+#include "Tracing.h"
+#include "ExtLogger.h"
+#include "CgroupNames.h"
+
+#define IO_QOS_CONFIG_FILE      "IoQosConfig.yaml"
+#define IO_QOS_DEFAULT_PATH     "/"
+#define IO_QOS_DEFAULT_DISK     0
+#define MOUNTINFO_PATH          "/proc/self/mountinfo"
+#define SYS_DEV_BLOCK_PATH      "/sys/dev/block/"
+
+static constexpr const char* kLogTag = "URM_EXT_IO_QOS";
+static constexpr uint32_t RES_CODE_CGRP_IO_LATENCY = 0x00090010;
+static constexpr uint32_t RES_CODE_CGRP_IO_MAX     = 0x00090011;
+
+// One disk line of a cgroup node: the line found before the first holder
+// and the settings of every holder, oldest first. The latest holder's
+// settings are in effect.
+typedef struct {
+    std::string mOriginal;
+    std::vector<std::string> mHolders;
+} IoQosDeviceState;
+
+// Cgroup node -> MAJ:MIN -> state
+typedef std::map<std::string, std::map<std::string, IoQosDeviceState>> IoQosHolders;
+
+static std::mutex gIoQosLock;
+static IoQosHolders gIoLatencyHolders;
+static IoQosHolders gIoMaxHolders;
+
+static std::string devToString(dev_t dev) {
+    return std::to_string(major(dev)) + ":" + std::to_string(minor(dev));
+}
+
+// Filesystems without a block device of their own (overlayfs, btrfs
+// subvolumes, ...) report an anonymous major 0 device, fall back to the
+// source of the mount carrying that device number.
+static bool mountSourceDevice(dev_t anonDev, dev_t& dev) {
+    std::ifstream fileStream(MOUNTINFO_PATH, std::ios::in);
+    if(!fileStream.is_open()) {
+        return false;
+    }
+
+    const std::string wanted = devToString(anonDev);
+    std::string line;
+    while(getline(fileStream, line)) {
+        // <id> <parent> <maj:min> <root> <mountpoint> ... - <fstype> <source> <opts>
+        std::istringstream iss(line);
+        std::string mountId, parentId, majMin;
+        if(!(iss >> mountId >> parentId >> majMin) || majMin != wanted) {
+            continue;
+        }
+
+        size_t sep = line.find(" - ");
+        if(sep == std::string::npos) {
+            continue;
+        }
+        std::istringstream tail(line.substr(sep + 3));
+        std::string fsType, source;
+        if(!(tail >> fsType >> source)) {
+            continue;
+        }
+
+        struct stat st;
+        if(stat(source.c_str(), &st) == 0 && S_ISBLK(st.st_mode)) {
+            dev = st.st_rdev;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Resolve the whole-disk major:minor backing path.
+ *
+ * io.latency and io.max act on the request queue, which partitions share
+ * with their parent disk, so partitions are mapped to the disk.
+ */
+static bool resolveBlockDevice(const std::string& path, std::string& majMin) {
+    struct stat st;
+    if(stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+
+    dev_t dev = st.st_dev;
+    if(major(dev) == 0 && !mountSourceDevice(dev, dev)) {
+        return false;
+    }
+
+    majMin = devToString(dev);
+    const std::string sysDir = std::string(SYS_DEV_BLOCK_PATH) + majMin + "/";
+    if(AuxRoutines::fileExists(sysDir + "partition")) {
+        std::string parent;
+        if(readLineFromFile(sysDir + "../dev", parent)) {
+            majMin = trim(parent);
+        }
+    }
+    return true;
+}
+
+// IoQosDisks entries, later files replace the entry with the same Disk id:
+//   - {Disk: 0, Path: "/"}
+static void parseIoQosConfig(const std::string& filePath, std::map<int32_t, std::string>& disks) {
+    std::ifstream fileStream(filePath, std::ios::in);
+    std::string line;
+    while(fileStream.is_open() && getline(fileStream, line)) {
+        std::string s = trim(line);
+        if(s.empty() || s[0] == '#' || s.find("Path:") == std::string::npos) continue;
+
+        std::string disk = flowField(s, "Disk");
+        std::string path = flowField(s, "Path");
+        if(disk.empty() || path.empty()) {
+            EXT_LOGE(kLogTag, "ignoring disk line: {}", s);
+            continue;
+        }
+        disks[static_cast<int32_t>(strtol(disk.c_str(), nullptr, 0))] = path;
+    }
+}
+
+// Whole disks behind the requested IoQosConfig.yaml disk ids. No id selects
+// disk 0, which falls back to "/" when no config lists it.
+static std::vector<std::string> getTargetDevices(const std::vector<int32_t>& diskIds) {
+    std::map<int32_t, std::string> disks;
+    std::string machineName;
+    fetchMachineName(machineName);
+    parseIoQosConfig(std::string(URM_TARGET_CONFIG_DIR) + IO_QOS_CONFIG_FILE, disks);
+    if(!machineName.empty()) {
+        parseIoQosConfig(std::string(URM_TARGET_CONFIG_DIR) + machineName + "/" + IO_QOS_CONFIG_FILE, disks);
+    }
+    if(disks.find(IO_QOS_DEFAULT_DISK) == disks.end()) {
+        disks[IO_QOS_DEFAULT_DISK] = IO_QOS_DEFAULT_PATH;
+    }
+
+    std::vector<int32_t> ids = diskIds;
+    if(ids.empty()) {
+        ids.push_back(IO_QOS_DEFAULT_DISK);
+    }
+
+    std::set<std::string> devices;
+    for(int32_t id : ids) {
+        auto it = disks.find(id);
+        if(it == disks.end()) {
+            EXT_LOGE(kLogTag, "unknown disk id {}", id);
+            continue;
+        }
+        std::string majMin;
+        if(resolveBlockDevice(it->second, majMin)) {
+            devices.insert(majMin);
+        } else {
+            EXT_LOGE(kLogTag, "No block device found for {}", it->second);
+        }
+    }
+    return std::vector<std::string>(devices.begin(), devices.end());
+}
+
+// Current configuration line of a device in io.latency / io.max, or the
+// given reset line if the device has no entry yet.
+static std::string currentDeviceLine(const std::string& node,
+                                     const std::string& majMin,
+                                     const std::string& resetLine) {
+    std::ifstream fileStream(node, std::ios::in);
+    std::string line;
+    while(fileStream.is_open() && getline(fileStream, line)) {
+        if(line.compare(0, majMin.size() + 1, majMin + " ") == 0) {
+            return trim(line);
+        }
+    }
+    return majMin + " " + resetLine;
+}
+
+static void writeDeviceLine(uint32_t cbResCode, const std::string& node, const std::string& value) {
+    TYPELOGV(NOTIFY_NODE_WRITE_S, node.c_str(), value.c_str());
+    int rc = traceWriteLineToFile(TRACE_CB_IO_QOS, cbResCode, node, value);
+    if(rc != 0) {
+        EXT_LOGE(kLogTag, "write '{}' to {} failed: {}", value, node, ExtErrno{rc});
+    }
+}
+
+static void applyDeviceLines(uint32_t cbResCode,
+                             const std::string& node,
+                             const std::vector<std::string>& devices,
+                             const std::string& settings,
+                             const std::string& resetLine,
+                             IoQosHolders& holders) {
+    const std::lock_guard<std::mutex> lock(gIoQosLock);
+    std::map<std::string, IoQosDeviceState>& states = holders[node];
+
+    for(const std::string& majMin : devices) {
+        auto it = states.find(majMin);
+        if(it == states.end()) {
+            it = states.emplace(majMin, IoQosDeviceState()).first;
+            it->second.mOriginal = currentDeviceLine(node, majMin, resetLine);
+        }
+        it->second.mHolders.push_back(settings);
+        writeDeviceLine(cbResCode, node, majMin + " " + settings);
+    }
+}
+
+/**
+ * @brief Drop one holder with these settings from each device.
+ *
+ * If it was the one in effect, the latest remaining holder's settings are
+ * written, the saved line once no holder is left.
+ */
+static void restoreDeviceLines(uint32_t cbResCode,
+                               const std::string& node,
+                               const std::vector<std::string>& devices,
+                               const std::string& settings,
+                               IoQosHolders& holders) {
+    const std::lock_guard<std::mutex> lock(gIoQosLock);
+    auto nodeIt = holders.find(node);
+    if(nodeIt == holders.end()) {
+        return;
+    }
+
+    for(const std::string& majMin : devices) {
+        auto it = nodeIt->second.find(majMin);
+        if(it == nodeIt->second.end()) continue;
+
+        std::vector<std::string>& held = it->second.mHolders;
+        auto h = std::find(held.rbegin(), held.rend(), settings);
+        if(h == held.rend()) continue;
+        bool inEffect = (h == held.rbegin());
+        held.erase(std::next(h).base());
+
+        if(held.empty()) {
+            TYPELOGV(NOTIFY_NODE_RESET, node.c_str(), it->second.mOriginal.c_str());
+            traceWriteLineToFile(TRACE_CB_IO_QOS, cbResCode, node, it->second.mOriginal);
+            nodeIt->second.erase(it);
+        } else if(inEffect) {
+            writeDeviceLine(cbResCode, node, majMin + " " + held.back());
+        }
+    }
+    if(nodeIt->second.empty()) {
+        holders.erase(nodeIt);
+    }
+}
+
+static bool getCgroupNode(Resource* resource, int32_t minValues,
+                          const char* fileName, std::string& node) {
+    if(resource->getValuesCount() < minValues) {
+        EXT_LOGE(kLogTag, "{}: expected {} values, got {}",
+                 fileName, minValues, resource->getValuesCount());
+        return false;
+    }
+
+    int32_t cgroupId = resource->getValueAt(0);
+    if(!getCgroupPath(cgroupId, node)) {
+        EXT_LOGE(kLogTag, "{}: unknown cgroup id {}", fileName, cgroupId);
+        return false;
+    }
+    node += fileName;
+    return true;
+}
+
+// Disk ids from position first on.
+static std::vector<int32_t> getDiskIds(Resource* resource, int32_t first) {
+    std::vector<int32_t> ids;
+    for(int32_t i = first; i < resource->getValuesCount(); i++) {
+        ids.push_back(resource->getValueAt(i));
+    }
+    return ids;
+}
+
+// Values: [cgroupId, targetUs, disk, ...]
+static std::string ioLatencySettings(Resource* resource) {
+    int32_t targetUs = resource->getValueAt(1);
+    return "target=" + (targetUs > 0 ? std::to_string(targetUs) : std::string("max"));
+}
+
+static void ioLatencyApplierCallback(void* context) {
+    if(context == nullptr) return;
+    Resource* resource = static_cast<Resource*>(context);
+    TraceScope scope(TRACE_EV_APPLY, TRACE_CB_IO_QOS, RES_CODE_CGRP_IO_LATENCY);
+
+    std::string node;
+    if(!getCgroupNode(resource, 2, "io.latency", node)) {
+        scope.mResult = -1;
+        return;
+    }
+    applyDeviceLines(RES_CODE_CGRP_IO_LATENCY, node, getTargetDevices(getDiskIds(resource, 2)),
+                     ioLatencySettings(resource), "target=max", gIoLatencyHolders);
+}
+
+static void ioLatencyTearCallback(void* context) {
+    if(context == nullptr) return;
+    Resource* resource = static_cast<Resource*>(context);
+    TraceScope scope(TRACE_EV_TEAR, TRACE_CB_IO_QOS, RES_CODE_CGRP_IO_LATENCY);
+
+    std::string node;
+    if(getCgroupNode(resource, 2, "io.latency", node)) {
+        restoreDeviceLines(RES_CODE_CGRP_IO_LATENCY, node, getTargetDevices(getDiskIds(resource, 2)),
+                           ioLatencySettings(resource), gIoLatencyHolders);
+    }
+}
+
+// Values: [cgroupId, rbpsKiB, wbpsKiB, riops, wiops, disk, ...]. Bandwidths
+// are in KiB/s so int32_t values reach beyond 2 GB/s. 0 or a missing value
+// leaves that limit unset ("max").
+static std::string ioMaxSettings(Resource* resource) {
+    static const char* const kKeys[] = {"rbps", "wbps", "riops", "wiops"};
+    std::string settings;
+    for(int32_t i = 0; i < 4; i++) {
+        int32_t v = (i + 1 < resource->getValuesCount()) ? resource->getValueAt(i + 1) : 0;
+        uint64_t limit = static_cast<uint64_t>(v > 0 ? v : 0);
+        if(i < 2) {
+            limit <<= 10;
+        }
+        if(!settings.empty()) settings += " ";
+        settings += std::string(kKeys[i]) + "=" + (limit > 0 ? std::to_string(limit) : std::string("max"));
+    }
+    return settings;
+}
+
+static void ioMaxApplierCallback(void* context) {
+    if(context == nullptr) return;
+    Resource* resource = static_cast<Resource*>(context);
+    TraceScope scope(TRACE_EV_APPLY, TRACE_CB_IO_QOS, RES_CODE_CGRP_IO_MAX);
+
+    std::string node;
+    if(!getCgroupNode(resource, 2, "io.max", node)) {
+        scope.mResult = -1;
+        return;
+    }
+    applyDeviceLines(RES_CODE_CGRP_IO_MAX, node, getTargetDevices(getDiskIds(resource, 5)),
+                     ioMaxSettings(resource), "rbps=max wbps=max riops=max wiops=max", gIoMaxHolders);
+}
+
+static void ioMaxTearCallback(void* context) {
+    if(context == nullptr) return;
+    Resource* resource = static_cast<Resource*>(context);
+    TraceScope scope(TRACE_EV_TEAR, TRACE_CB_IO_QOS, RES_CODE_CGRP_IO_MAX);
+
+    std::string node;
+    if(getCgroupNode(resource, 2, "io.max", node)) {
+        restoreDeviceLines(RES_CODE_CGRP_IO_MAX, node, getTargetDevices(getDiskIds(resource, 5)),
+                           ioMaxSettings(resource), gIoMaxHolders);
+    }
+}
+
+URM_REGISTER_RES_APPLIER_CB(0x00090010, ioLatencyApplierCallback)
+URM_REGISTER_RES_TEAR_CB   (0x00090010, ioLatencyTearCallback)
+
+URM_REGISTER_RES_APPLIER_CB(0x00090011, ioMaxApplierCallback)
+URM_REGISTER_RES_TEAR_CB   (0x00090011, ioMaxTearCallback)
@@ -0,0 +1,110 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ExtLogger.h"
+#include "IrqAffinity.h"
+
+struct IrqAffinityHolder {
+    uint32_t mOwner;
+    std::string mMask;
+};
+
+struct IrqAffinityState {
+    std::string mOriginal;
+    std::vector<IrqAffinityHolder> mHolders;    // oldest first
+};
+
+class IrqAffinityArbiter {
+private:
+    static std::once_flag mInitFlag;
+    static std::unique_ptr<IrqAffinityArbiter> mInstance;
+
+    std::mutex mLock;
+    std::map<std::string, IrqAffinityState> mIrqs;
+
+    IrqAffinityArbiter() = default;
+    IrqAffinityArbiter(const IrqAffinityArbiter&) = delete;
+    IrqAffinityArbiter& operator=(const IrqAffinityArbiter&) = delete;
+
+public:
+    static IrqAffinityArbiter& getInstance() {
+        std::call_once(mInitFlag, [] {
+            mInstance.reset(new IrqAffinityArbiter());
+        });
+        return *mInstance;
+    }
+
+    ~IrqAffinityArbiter() = default;
+    void hold(uint32_t owner, const std::string& path,
+              const std::string& curVal, const std::string& mask);
+    void release(uint32_t owner, std::vector<std::pair<std::string, std::string>>& writes);
+};
+
+std::once_flag IrqAffinityArbiter::mInitFlag;
+std::unique_ptr<IrqAffinityArbiter> IrqAffinityArbiter::mInstance = nullptr;
+
+void IrqAffinityArbiter::hold(uint32_t owner, const std::string& path,
+                              const std::string& curVal, const std::string& mask) {
+    const std::lock_guard<std::mutex> lock(mLock);
+
+    auto it = mIrqs.find(path);
+    if(it == mIrqs.end()) {
+        it = mIrqs.emplace(path, IrqAffinityState()).first;
+        it->second.mOriginal = curVal;
+    }
+
+    // A repeated apply by the same owner moves it to the top.
+    std::vector<IrqAffinityHolder>& holders = it->second.mHolders;
+    for(auto h = holders.begin(); h != holders.end(); ++h) {
+        if(h->mOwner == owner) {
+            holders.erase(h);
+            break;
+        }
+    }
+    holders.push_back({owner, mask});
+}
+
+void IrqAffinityArbiter::release(uint32_t owner,
+                                 std::vector<std::pair<std::string, std::string>>& writes) {
+    const std::lock_guard<std::mutex> lock(mLock);
+
+    for(auto it = mIrqs.begin(); it != mIrqs.end();) {
+        std::vector<IrqAffinityHolder>& holders = it->second.mHolders;
+        bool wasTop = false;
+        for(auto h = holders.begin(); h != holders.end(); ++h) {
+            if(h->mOwner == owner) {
+                wasTop = (h + 1 == holders.end());
+                holders.erase(h);
+                break;
+            }
+        }
+
+        if(holders.empty()) {
+            writes.emplace_back(it->first, it->second.mOriginal);
+            it = mIrqs.erase(it);
+            continue;
+        }
+        if(wasTop) {
+            EXT_LOGD("URM_EXT_IRQ", "{} back to holder {}",
+                     it->first, ExtHex{holders.back().mOwner});
+            writes.emplace_back(it->first, holders.back().mMask);
+        }
+        ++it;
+    }
+}
+
+void holdIrqAffinity(uint32_t owner, const std::string& path,
+                     const std::string& curVal, const std::string& mask) {
+    IrqAffinityArbiter::getInstance().hold(owner, path, curVal, mask);
+}
+
+void releaseIrqAffinity(uint32_t owner,
+                        std::vector<std::pair<std::string, std::string>>& writes) {
+    IrqAffinityArbiter::getInstance().release(owner, writes);
+}
@@ -0,0 +1,328 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <condition_variable>
+
+#include "Helpers.h"
+#include "Tracing.h"
+#include "ExtStats.h"
+#include "ExtLogger.h"
+#include "CgroupNames.h"
+
+#define RECLAIM_STEP_MIN_BYTES  (4ULL << 20)
+#define RECLAIM_STEP_MAX_BYTES  (64ULL << 20)
+#define RECLAIM_DEF_BUDGET_MS   500
+#define RECLAIM_MIN_BUDGET_MS   50
+#define RECLAIM_MAX_BUDGET_MS   5000
+#define RECLAIM_DEF_CGROUP_ID   2       // Background cgroup
+#define RECLAIM_DEF_CGROUP_NAME "system-background"
+
+static constexpr const char* kLogTag = "URM_EXT_MEM_RECLAIM";
+static constexpr uint32_t RES_CODE_MEM_RECLAIM = 0x00810001;
+
+typedef struct {
+    uint64_t mTargetBytes;                  // MemFree to reach
+    uint32_t mBudgetMs;
+    std::vector<std::string> mCgroupDirs;   // With a trailing '/'
+    std::string mOwner;                     // Values of the applying resource
+} ReclaimRequest;
+
+// Runs one reclaim job at a time on its own thread, so the applier returns
+// right away. A newer request stops the running job and takes its place.
+// A tear only stops the job of the holder being torn.
+class MemReclaimer {
+private:
+    static std::once_flag mInitFlag;
+    static std::unique_ptr<MemReclaimer> mInstance;
+
+    std::mutex mLock;
+    std::condition_variable mWake;
+    std::thread mThread;
+    bool mPending;
+    bool mCancel;
+    bool mStop;
+    ReclaimRequest mRequest;
+    std::string mRunningOwner;      // Empty while idle
+
+    bool isCancelled();
+    void runJob(const ReclaimRequest& request);
+    void workerLoop();
+
+    MemReclaimer() : mPending(false), mCancel(false), mStop(false) {}
+    MemReclaimer(const MemReclaimer&) = delete;
+    MemReclaimer& operator=(const MemReclaimer&) = delete;
+
+public:
+    static MemReclaimer& getInstance() {
+        std::call_once(mInitFlag, [] {
+            mInstance.reset(new MemReclaimer());
+        });
+        return *mInstance;
+    }
+
+    ~MemReclaimer();
+    void submit(const ReclaimRequest& request);
+    void cancel(const std::string& owner);
+};
+
+std::once_flag MemReclaimer::mInitFlag;
+std::unique_ptr<MemReclaimer> MemReclaimer::mInstance = nullptr;
+
+// memory.current of a cgroup in bytes, 0 if unreadable.
+static uint64_t readMemCurrent(const std::string& cgroupDir) {
+    std::string line;
+    if(!readLineFromFile(cgroupDir + "memory.current", line)) {
+        return 0;
+    }
+    return strtoull(line.c_str(), nullptr, 10);
+}
+
+// writeLineToFile() folds every failure into EIO, memory.reclaim reports
+// that it could not reclaim the full amount through EAGAIN.
+static int writeReclaimNode(const std::string& node, uint64_t bytes) {
+    TraceScope scope(TRACE_EV_NODE_WRITE, TRACE_CB_MEM_RECLAIM, RES_CODE_MEM_RECLAIM, node);
+    const std::string value = std::to_string(bytes);
+
+    int rc = 0;
+    int fd = open(node.c_str(), O_WRONLY | O_CLOEXEC);
+    if(fd < 0) {
+        rc = errno;
+    } else {
+        if(write(fd, value.data(), value.size()) < 0) {
+            rc = errno;
+        }
+        close(fd);
+    }
+    scope.mResult = rc;
+    return rc;
+}
+
+MemReclaimer::~MemReclaimer() {
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        mStop = true;
+        mCancel = true;
+    }
+    mWake.notify_all();
+    if(mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+bool MemReclaimer::isCancelled() {
+    const std::lock_guard<std::mutex> lock(mLock);
+    return mCancel;
+}
+
+/**
+ * @brief Reclaim from the given cgroups until MemFree reaches the target.
+ *
+ * MemAvailable already counts clean page cache, which is most of what
+ * memory.reclaim frees, so it barely moves. MemFree does.
+ *
+ * Steps go round-robin over the cgroups and are capped at
+ * RECLAIM_STEP_MAX_BYTES, so a single write never blocks for long and the
+ * budget is checked often. A cgroup which returns EAGAIN has nothing left
+ * to give at the current pressure and is dropped from the rotation.
+ */
+void MemReclaimer::runJob(const ReclaimRequest& request) {
+    uint64_t available = readMemFree();
+    if(available >= request.mTargetBytes) {
+        EXT_LOGD(kLogTag, "MemFree {} already at target {}", available, request.mTargetBytes);
+        return;
+    }
+
+    const uint64_t startNs = traceNowNs();
+    const uint64_t deadlineNs = startNs + static_cast<uint64_t>(request.mBudgetMs) * 1000000ULL;
+    std::vector<std::string> cgroups = request.mCgroupDirs;
+    uint64_t reclaimed = 0;
+    bool timedOut = false;
+    bool cancelled = false;
+    size_t next = 0;
+
+    while(available < request.mTargetBytes && !cgroups.empty()) {
+        if(isCancelled()) {
+            cancelled = true;
+            break;
+        }
+        if(traceNowNs() >= deadlineNs) {
+            timedOut = true;
+            break;
+        }
+
+        const std::string& dir = cgroups[next];
+        uint64_t step = std::min<uint64_t>(std::max<uint64_t>(request.mTargetBytes - available,
+                                                              RECLAIM_STEP_MIN_BYTES),
+                                           RECLAIM_STEP_MAX_BYTES);
+
+        uint64_t before = readMemCurrent(dir);
+        int rc = writeReclaimNode(dir + "memory.reclaim", step);
+        uint64_t after = readMemCurrent(dir);
+        if(before > after) {
+            reclaimed += before - after;
+        }
+
+        if(rc != 0) {
+            if(rc != EAGAIN) {
+                EXT_LOGE(kLogTag, "reclaim from {} failed: {}", dir, ExtErrno{rc});
+            }
+            cgroups.erase(cgroups.begin() + next);
+        } else {
+            next++;
+        }
+        if(next >= cgroups.size()) {
+            next = 0;
+        }
+        available = readMemFree();
+    }
+
+    uint64_t durationNs = traceNowNs() - startNs;
+    statAdd(STAT_RECLAIM_JOBS, 1);
+    if(timedOut) {
+        statAdd(STAT_RECLAIM_TIMEOUTS, 1);
+    }
+    statAdd(STAT_RECLAIM_BYTES, reclaimed);
+    statSet(STAT_RECLAIM_LAST_BYTES, reclaimed);
+    statSet(STAT_RECLAIM_LAST_US, durationNs / 1000);
+    traceEvent(TRACE_EV_RECLAIM, TRACE_CB_MEM_RECLAIM, RES_CODE_MEM_RECLAIM, 0,
+               durationNs, static_cast<int64_t>(reclaimed));
+
+    EXT_LOGI(kLogTag, "{} bytes in {} us, MemFree {} of {}{}", reclaimed, durationNs / 1000,
+             available, request.mTargetBytes,
+             timedOut ? " (budget hit)" : (cancelled ? " (cancelled)" : ""));
+    statsPublish();
+}
+
+void MemReclaimer::workerLoop() {
+    for(;;) {
+        ReclaimRequest request;
+        {
+            std::unique_lock<std::mutex> lock(mLock);
+            mWake.wait(lock, [this] { return mStop || mPending; });
+            if(mStop) return;
+            request = mRequest;
+            mPending = false;
+            mCancel = false;
+            mRunningOwner = request.mOwner;
+        }
+        runJob(request);
+
+        const std::lock_guard<std::mutex> lock(mLock);
+        mRunningOwner.clear();
+    }
+}
+
+void MemReclaimer::submit(const ReclaimRequest& request) {
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        mRequest = request;
+        mPending = true;
+        mCancel = true;
+        if(!mThread.joinable()) {
+            mThread = std::thread(&MemReclaimer::workerLoop, this);
+        }
+    }
+    mWake.notify_one();
+}
+
+void MemReclaimer::cancel(const std::string& owner) {
+    const std::lock_guard<std::mutex> lock(mLock);
+    if(mPending && mRequest.mOwner == owner) {
+        mPending = false;
+    }
+    if(mRunningOwner == owner) {
+        mCancel = true;
+    }
+}
+
+// Holders are told apart by their Values, the tear gets the same ones.
+static std::string reclaimOwner(Resource* resource) {
+    std::string owner;
+    for(int32_t i = 0; i < resource->getValuesCount(); i++) {
+        owner += std::to_string(resource->getValueAt(i)) + ",";
+    }
+    return owner;
+}
+
+// The background cgroup is created by the URM core and is often not listed
+// in any CgroupsInfo the plugin reads, so the default id falls back to its
+// directory.
+static bool resolveReclaimCgroup(int32_t cgroupId, std::string& dir) {
+    if(getCgroupPath(cgroupId, dir)) {
+        return true;
+    }
+    if(cgroupId != RECLAIM_DEF_CGROUP_ID) {
+        return false;
+    }
+    dir = std::string(CGROUP_V2_ROOT) + RECLAIM_DEF_CGROUP_NAME + "/";
+    return isWritable(dir + "memory.reclaim");
+}
+
+// Values: [targetMb, budgetMs, cgroupId, ...], budgetMs and the cgroup ids
+// are optional (500 ms, background cgroup).
+static void memReclaimApplierCallback(void* context) {
+    if(context == nullptr) return;
+    Resource* resource = static_cast<Resource*>(context);
+    TraceScope scope(TRACE_EV_APPLY, TRACE_CB_MEM_RECLAIM, RES_CODE_MEM_RECLAIM);
+
+    int32_t count = resource->getValuesCount();
+    if(count < 1 || resource->getValueAt(0) <= 0) {
+        EXT_LOGE(kLogTag, "expected [targetMb, budgetMs, cgroupId, ...] with targetMb > 0");
+        scope.mResult = -1;
+        return;
+    }
+
+    ReclaimRequest request;
+    request.mOwner = reclaimOwner(resource);
+    request.mTargetBytes = static_cast<uint64_t>(resource->getValueAt(0)) << 20;
+    request.mBudgetMs = RECLAIM_DEF_BUDGET_MS;
+    if(count > 1 && resource->getValueAt(1) > 0) {
+        request.mBudgetMs = std::min<uint32_t>(std::max<uint32_t>(resource->getValueAt(1), RECLAIM_MIN_BUDGET_MS),
+                                               RECLAIM_MAX_BUDGET_MS);
+    }
+
+    std::vector<int32_t> cgroupIds;
+    for(int32_t i = 2; i < count; i++) {
+        cgroupIds.push_back(resource->getValueAt(i));
+    }
+    if(cgroupIds.empty()) {
+        cgroupIds.push_back(RECLAIM_DEF_CGROUP_ID);
+    }
+
+    for(int32_t cgroupId : cgroupIds) {
+        std::string dir;
+        if(!resolveReclaimCgroup(cgroupId, dir)) {
+            EXT_LOGE(kLogTag, "unknown cgroup id {}", cgroupId);
+            continue;
+        }
+        request.mCgroupDirs.push_back(dir);
+    }
+    if(request.mCgroupDirs.empty()) {
+        scope.mResult = -1;
+        return;
+    }
+
+    MemReclaimer::getInstance().submit(request);
+}
+
+// Reclaimed memory is not given back, tear only stops this holder's job if
+// it is still queued or running. A newer job of another holder keeps going.
+static void memReclaimTearCallback(void* context) {
+    if(context == nullptr) return;
+    Resource* resource = static_cast<Resource*>(context);
+    TraceScope scope(TRACE_EV_TEAR, TRACE_CB_MEM_RECLAIM, RES_CODE_MEM_RECLAIM);
+    MemReclaimer::getInstance().cancel(reclaimOwner(resource));
+}
+
+URM_REGISTER_RES_APPLIER_CB(0x00810001, memReclaimApplierCallback)
+URM_REGISTER_RES_TEAR_CB   (0x00810001, memReclaimTearCallback)
@@ -0,0 +1,268 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <condition_variable>
+
+#include "Helpers.h"
+#include "Tracing.h"
+#include "ExtStats.h"
+#include "ExtLogger.h"
+#include "ProcExitWatcher.h"
+#include "PageCachePrewarm.h"
+
+#define PREWARM_WORKERS      4
+#define PREWARM_CHUNK_BYTES  (16ULL << 20)
+#define PREWARM_MEM_PERCENT  50     // Share of MemAvailable one job may pull in
+
+static constexpr const char* kLogTag = "URM_EXT_PREWARM";
+
+// Files of one prewarm request, closed once the last chunk is done.
+class PrewarmJob {
+public:
+    pid_t mPid;
+    uint64_t mStartNs;
+    std::vector<int> mFds;
+    std::atomic<bool> mCancelled;
+    std::atomic<uint32_t> mPending;
+    std::atomic<uint64_t> mBytes;
+
+    explicit PrewarmJob(pid_t pid)
+        : mPid(pid), mStartNs(traceNowNs()), mCancelled(false), mPending(0), mBytes(0) {}
+
+    ~PrewarmJob() {
+        for(int fd : mFds) {
+            close(fd);
+        }
+    }
+};
+
+typedef struct {
+    std::shared_ptr<PrewarmJob> mJob;
+    int mFd;
+    off_t mOffset;
+    size_t mLength;
+} PrewarmChunk;
+
+// Request whose file list still has to be collected.
+typedef struct {
+    pid_t mPid;
+    PrewarmFileCollector mCollect;
+} PrewarmRequest;
+
+class PageCachePrewarmer {
+private:
+    static std::once_flag mInitFlag;
+    static std::unique_ptr<PageCachePrewarmer> mInstance;
+
+    std::mutex mLock;
+    std::condition_variable mWake;
+    std::deque<PrewarmRequest> mRequests;   // Served before mQueue
+    std::deque<PrewarmChunk> mQueue;
+    std::vector<std::thread> mWorkers;
+    bool mStop;
+
+    void workerLoop();
+    void finishJob(const std::shared_ptr<PrewarmJob>& job);
+    void submit(pid_t pid, const std::vector<std::string>& files);
+
+    PageCachePrewarmer() : mStop(false) {}
+    PageCachePrewarmer(const PageCachePrewarmer&) = delete;
+    PageCachePrewarmer& operator=(const PageCachePrewarmer&) = delete;
+
+public:
+    static PageCachePrewarmer& getInstance() {
+        std::call_once(mInitFlag, [] {
+            mInstance.reset(new PageCachePrewarmer());
+        });
+        return *mInstance;
+    }
+
+    ~PageCachePrewarmer();
+    void request(pid_t pid, const PrewarmFileCollector& collect);
+};
+
+std::once_flag PageCachePrewarmer::mInitFlag;
+std::unique_ptr<PageCachePrewarmer> PageCachePrewarmer::mInstance = nullptr;
+
+PageCachePrewarmer::~PageCachePrewarmer() {
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        mStop = true;
+        mRequests.clear();
+        mQueue.clear();
+    }
+    mWake.notify_all();
+    for(std::thread& worker : mWorkers) {
+        if(worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void PageCachePrewarmer::finishJob(const std::shared_ptr<PrewarmJob>& job) {
+    uint64_t durationNs = traceNowNs() - job->mStartNs;
+    uint64_t bytes = job->mBytes.load(std::memory_order_relaxed);
+    bool cancelled = job->mCancelled.load(std::memory_order_relaxed);
+
+    if(cancelled) {
+        statAdd(STAT_PREWARM_CANCELLED, 1);
+    }
+    statSet(STAT_PREWARM_LAST_US, durationNs / 1000);
+    traceEvent(TRACE_EV_PREWARM, TRACE_CB_PREWARM, 0, 0, durationNs, static_cast<int64_t>(bytes));
+
+    EXT_LOGI(kLogTag, "pid {}: {} bytes in {} us{}", job->mPid, bytes, durationNs / 1000,
+             cancelled ? " (cancelled)" : "");
+    statsPublish();
+}
+
+void PageCachePrewarmer::workerLoop() {
+    for(;;) {
+        PrewarmChunk chunk;
+        PrewarmRequest request;
+        bool haveRequest = false;
+        {
+            std::unique_lock<std::mutex> lock(mLock);
+            mWake.wait(lock, [this] { return mStop || !mRequests.empty() || !mQueue.empty(); });
+            if(mStop) return;
+            if(!mRequests.empty()) {
+                request = mRequests.front();
+                mRequests.pop_front();
+                haveRequest = true;
+            } else {
+                chunk = mQueue.front();
+                mQueue.pop_front();
+            }
+        }
+
+        if(haveRequest) {
+            std::vector<std::string> files;
+            request.mCollect(files);
+            if(!files.empty()) {
+                submit(request.mPid, files);
+            }
+            continue;
+        }
+
+        PrewarmJob* job = chunk.mJob.get();
+        if(!job->mCancelled.load(std::memory_order_relaxed)) {
+            // readahead() is not supported by every filesystem (e.g. FUSE),
+            // posix_fadvise() is the portable way to ask for the same.
+            bool queued = readahead(chunk.mFd, chunk.mOffset, chunk.mLength) == 0 ||
+                          posix_fadvise(chunk.mFd, chunk.mOffset, chunk.mLength, POSIX_FADV_WILLNEED) == 0;
+            if(queued) {
+                job->mBytes.fetch_add(chunk.mLength, std::memory_order_relaxed);
+                statAdd(STAT_PREWARM_BYTES, chunk.mLength);
+            } else {
+                statAdd(STAT_PREWARM_FAILED_BYTES, chunk.mLength);
+            }
+        }
+
+        if(job->mPending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            finishJob(chunk.mJob);
+        }
+    }
+}
+
+void PageCachePrewarmer::submit(pid_t pid, const std::vector<std::string>& files) {
+    std::shared_ptr<PrewarmJob> job = std::make_shared<PrewarmJob>(pid);
+
+    uint64_t budget = readMemAvailable() * PREWARM_MEM_PERCENT / 100;
+    uint64_t skipped = 0;
+    std::vector<PrewarmChunk> chunks;
+
+    for(const std::string& path : files) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0) {
+            continue;
+        }
+
+        struct stat st;
+        if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+            close(fd);
+            continue;
+        }
+
+        uint64_t size = static_cast<uint64_t>(st.st_size);
+        if(size > budget) {
+            // Reading it would only push out pages the workload needs.
+            skipped += size;
+            close(fd);
+            continue;
+        }
+        budget -= size;
+
+        job->mFds.push_back(fd);
+        for(uint64_t offset = 0; offset < size; offset += PREWARM_CHUNK_BYTES) {
+            size_t length = static_cast<size_t>(std::min<uint64_t>(PREWARM_CHUNK_BYTES, size - offset));
+            chunks.push_back({job, fd, static_cast<off_t>(offset), length});
+        }
+    }
+
+    statAdd(STAT_PREWARM_SKIPPED_BYTES, skipped);
+    if(chunks.empty()) {
+        EXT_LOGD(kLogTag, "pid {}: nothing to prewarm, skipped {} bytes", pid, skipped);
+        return;
+    }
+
+    // Only a weak reference is kept by the watcher, so the files are closed
+    // as soon as the job completes rather than when the process exits.
+    std::weak_ptr<PrewarmJob> weakJob = job;
+    int rc = watchProcessExit(pid, [weakJob](pid_t) {
+        std::shared_ptr<PrewarmJob> exitedJob = weakJob.lock();
+        if(exitedJob != nullptr) {
+            exitedJob->mCancelled.store(true, std::memory_order_relaxed);
+        }
+    });
+    if(rc == ESRCH) {
+        return;
+    }
+
+    statAdd(STAT_PREWARM_JOBS, 1);
+    statAdd(STAT_PREWARM_FILES, job->mFds.size());
+    job->mPending.store(static_cast<uint32_t>(chunks.size()), std::memory_order_relaxed);
+    EXT_LOGI(kLogTag, "pid {}: prewarming {} files in {} chunks, skipped {} bytes",
+             pid, static_cast<uint32_t>(job->mFds.size()), static_cast<uint32_t>(chunks.size()), skipped);
+
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        for(const PrewarmChunk& chunk : chunks) {
+            mQueue.push_back(chunk);
+        }
+    }
+    mWake.notify_all();
+}
+
+void PageCachePrewarmer::request(pid_t pid, const PrewarmFileCollector& collect) {
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        if(mWorkers.empty()) {
+            for(int32_t i = 0; i < PREWARM_WORKERS; i++) {
+                mWorkers.emplace_back(&PageCachePrewarmer::workerLoop, this);
+            }
+        }
+        mRequests.push_back({pid, collect});
+    }
+    mWake.notify_one();
+}
+
+void prewarmFiles(pid_t pid, const PrewarmFileCollector& collect) {
+    // On by default, URM_EXT_PREWARM=0 turns it off.
+    static const bool enabled = std::getenv("URM_EXT_PREWARM") == nullptr ||
+                                parseBoolEnv(std::getenv("URM_EXT_PREWARM"));
+    if(!enabled) {
+        return;
+    }
+    PageCachePrewarmer::getInstance().request(pid, collect);
+}
@@ -2,14 +2,15 @@
 // SPDX-License-Identifier: BSD-3-Clause-Clear
 
 #include "PredefCallbacks.h"
-
-static std::vector<std::pair<std::string, std::string>> gIrqAffBackup;
+#include "Tracing.h"
+#include "IrqAffinity.h"
 
 void irqAffinityApplierCallback(void* context) {
     if(context == nullptr) return;
     Resource* resource = static_cast<Resource*>(context);
+    TraceScope scope(TRACE_EV_APPLY, TRACE_CB_IRQ_AFFINE_ALL, resource->getResCode());
 
-    gIrqAffBackup.clear();
+    uint32_t count = 0;
     uint64_t mask = 0;
     for(int32_t i = 0; i < resource->getValuesCount(); i++) {
         mask |= ((uint64_t)1 << (resource->getValueAt(i)));
@@ -27,8 +28,6 @@ void irqAffinityApplierCallback(void* context) {
         filePath.append("smp_affinity");
 
         if(AuxRoutines::fileExists(filePath)) {
-            gIrqAffBackup.emplace_back(filePath, AuxRoutines::readFromFile(filePath));
-
             // Convert to hex
             std::ostringstream oss;
             oss<<std::hex<<std::nouppercase;
@@ -38,21 +37,31 @@ void irqAffinityApplierCallback(void* context) {
                 oss<<mask;
             }
             std::string hexMask = oss.str();
+            holdIrqAffinity(resource->getResCode(), filePath,
+                            AuxRoutines::readFromFile(filePath), hexMask);
+            count++;
             TYPELOGV(NOTIFY_NODE_WRITE_S, filePath.c_str(), hexMask.c_str());
+            TraceScope writeScope(TRACE_EV_NODE_WRITE, TRACE_CB_IRQ_AFFINE_ALL,
+                                  resource->getResCode(), filePath);
             AuxRoutines::writeToFile(filePath, hexMask);
         }
     }
     closedir(dir);
+    scope.mResult = count;
 }
 
 void irqAffinityTearCallback(void* context) {
     if(context == nullptr) return;
+    Resource* resource = static_cast<Resource*>(context);
+    TraceScope scope(TRACE_EV_TEAR, TRACE_CB_IRQ_AFFINE_ALL, resource->getResCode());
 
-    for(const auto& kv : gIrqAffBackup) {
+    // Another holder (e.g. RES_IRQ_AFFINITY) may still need its mask.
+    std::vector<std::pair<std::string, std::string>> writes;
+    releaseIrqAffinity(resource->getResCode(), writes);
+    for(const auto& kv : writes) {
         const std::string& path = kv.first;
-        const std::string& oldVal = kv.second;
-        TYPELOGV(NOTIFY_NODE_RESET, path.c_str(), oldVal.c_str());
-        AuxRoutines::writeToFile(path, oldVal);
+        const std::string& val = kv.second;
+        TYPELOGV(NOTIFY_NODE_RESET, path.c_str(), val.c_str());
+        AuxRoutines::writeToFile(path, val);
     }
-    gIrqAffBackup.clear();
 }
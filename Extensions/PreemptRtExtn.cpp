@@ -5,13 +5,17 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <mutex>
 #include <cctype>
 #include <cstdlib>
 #include <cerrno>
 #include <cstring>
+#include <fstream>
 #include <strings.h>
 
+#include <sched.h>
 #include <dirent.h>
+#include <fnmatch.h>
 #include <unistd.h>
 #include <sys/utsname.h>
 
@@ -21,49 +25,46 @@
 #include <Urm/TargetRegistry.h>
 
 #include "Helpers.h"
+#include "Tracing.h"
+#include "ExtLogger.h"
+#include "ConfigWatcher.h"
+#include "IrqAffinity.h"
 
 #define POLICY_DIR_PATH "/sys/devices/system/cpu/cpufreq/"
 #define IRQ_DIR_PATH    "/proc/irq/"
 #define WQ_DIR_PATH     "/sys/devices/virtual/workqueue/"
+#define PROC_DIR_PATH   "/proc/"
+#define IRQ_THREAD_CONFIG_FILE "IrqThreadConfig.yaml"
 
 // ---------------------------
 // Conditional logging (URM_EXT__RT)
 // ---------------------------
-static bool gLogInit = false;
-static bool gLogEnabled = false;
 static constexpr const char* kLogTag = "urm-ext-rt";
 static constexpr uint64_t CPU_COUNT = 8;
 constexpr uint64_t VALID_MASK = (1ULL << CPU_COUNT) - 1;
 
-static bool parseBoolEnv(const char* v) {
-    if (!v) return false;
-    return (!strcasecmp(v, "1") || !strcasecmp(v, "true") ||
-            !strcasecmp(v, "on") || !strcasecmp(v, "yes") ||
-            !strcasecmp(v, "y"));
-}
+static constexpr uint32_t RES_CODE_CPU_FREQ_GOV     = 0x00800001;
+static constexpr uint32_t RES_CODE_IRQ_AFFINITY     = 0x00800002;
+static constexpr uint32_t RES_CODE_CPU_WQ_AFFINITY  = 0x00800003;
+static constexpr uint32_t RES_CODE_IRQ_THREAD_PRIO  = 0x00800004;
 
 static inline bool isLogEnabled() {
-    if (!gLogInit) {
-        gLogEnabled = parseBoolEnv(std::getenv("URM_EXT_RT"));
-        gLogInit = true;
-    }
-    return gLogEnabled;
-}
-
-static void logLine(const std::string& msg) {
-    if (!isLogEnabled()) return;
-    LOGI(kLogTag, msg.c_str());
+    // Initialised once on first use, thread-safe as a function-local static.
+    static const bool enabled = parseBoolEnv(std::getenv("URM_EXT_RT"));
+    return enabled;
 }
 
+// Records are queued on the plugin log ring, formatting happens off this thread.
+#define RT_LOG(...) do { if (isLogEnabled()) EXT_LOGI(kLogTag, __VA_ARGS__); } while (0)
 
 static inline void logWriteFailure(const std::string& path, int rc) {
-    if (!isLogEnabled()) return;
-    const int e = (rc < 0) ? -rc : rc;
-    const char* err = strerror(e);
-    std::string msg = "write failed for " + path +
-                      " rc=" + std::to_string(rc) +
-                      " err='" + std::string(err ? err : "unknown") + "'";
-    logLine(msg);
+    RT_LOG("write failed for {} rc={} err='{}'", path, rc, ExtErrno{rc < 0 ? -rc : rc});
+}
+
+static inline void logSchedFailure(const std::string& comm, pid_t tid,
+                                   int32_t policy, int32_t prio, int err) {
+    RT_LOG("sched_setscheduler failed for {} ({}) policy {} prio {} err='{}'",
+           comm, tid, policy, prio, ExtErrno{err});
 }
 
 // ---------------------------
@@ -73,7 +74,7 @@ static bool isPreemptRtActive() {
     std::string rt;
     if (readLineFromFile("/sys/kernel/realtime", rt)) {
         rt = trim(rt);
-        if (isLogEnabled()) logLine(std::string("/sys/kernel/realtime = '") + rt + "'");
+        RT_LOG("/sys/kernel/realtime = '{}'", rt);
         if (rt == "1") return true;
         if (rt == "0") return false;
     }
@@ -81,7 +82,7 @@ static bool isPreemptRtActive() {
     if (uname(&u) == 0) {
         std::string ver(u.version);
         toLower(ver);
-        if (isLogEnabled()) logLine(std::string("uname -v: ") + u.version);
+        RT_LOG("uname -v: {}", u.version);
         if (ver.find("preempt rt") != std::string::npos || ver.find("preempt_rt") != std::string::npos) {
             return true;
         }
@@ -96,7 +97,8 @@ static bool gCpufreqApplied = false;
 static std::vector<std::pair<std::string, std::string>> gCpufreqGovBackup;
 
 static void cpufreqGovApplierCallback(void* /*context*/) {
-    logLine("enter cpufreqGovApplierCallback");
+    RT_LOG("enter cpufreqGovApplierCallback");
+    TraceScope scope(TRACE_EV_APPLY, TRACE_CB_CPUFREQ_GOV, RES_CODE_CPU_FREQ_GOV);
 
     if (gCpufreqApplied) return;
 
@@ -119,27 +121,29 @@ static void cpufreqGovApplierCallback(void* /*context*/) {
         std::string oldVal;
         if (readLineFromFile(govFile, oldVal)) {
             gCpufreqGovBackup.emplace_back(govFile, oldVal);
-            logLine("[" + std::string(entry->d_name) + "] old governor: " + oldVal);
-            int rc = writeLineToFile(govFile, "performance");
+            RT_LOG("[{}] old governor: {}", entry->d_name, oldVal);
+            int rc = traceWriteLineToFile(TRACE_CB_CPUFREQ_GOV, RES_CODE_CPU_FREQ_GOV, govFile, "performance");
             if (rc != 0) {
                logWriteFailure(govFile, rc);
             }
             
-            if (rc == 0) {
+            if (rc == 0 && isLogEnabled()) {
                 std::string now;
                 if (readLineFromFile(govFile, now)) {
-                    logLine("verify " + govFile + " -> " + now);
+                    RT_LOG("verify {} -> {}", govFile, now);
                 }
             }
         }
     }
     closedir(dir);
     gCpufreqApplied = !gCpufreqGovBackup.empty();
+    scope.mResult = gCpufreqGovBackup.size();
 }
 
 static void cpufreqGovTearCallback(void* /*context*/) {
     if (!gCpufreqApplied) return;
-    logLine("enter cpufreqTearCallback");
+    RT_LOG("enter cpufreqTearCallback");
+    TraceScope scope(TRACE_EV_TEAR, TRACE_CB_CPUFREQ_GOV, RES_CODE_CPU_FREQ_GOV);
 
     for (const auto& kv : gCpufreqGovBackup) {
         const std::string& path = kv.first;
@@ -154,15 +158,14 @@ static void cpufreqGovTearCallback(void* /*context*/) {
 // IRQ affinity: apply/tear
 // ---------------------------
 static bool gIrqApplied = false;
-static std::vector<std::pair<std::string, std::string>> gIrqAffBackup;
 
 static void irqAffinityApplierCallback(void* /*context*/) {
-    logLine("enter irqAffinityApplierCallback");
+    RT_LOG("enter irqAffinityApplierCallback");
+    TraceScope scope(TRACE_EV_APPLY, TRACE_CB_IRQ_AFFINITY, RES_CODE_IRQ_AFFINITY);
 
     if (gIrqApplied) return;
 
-    gIrqAffBackup.clear();
-
+    uint32_t count = 0;
     int32_t args[2] = {GET_MAX_CLUSTER, -1};
     uint64_t hexMask = GET_TARGET_INFO(GET_MASK, 2, args);
     std::string maskStr = cpuMaskToHex((~(hexMask) & VALID_MASK ));
@@ -185,34 +188,39 @@ static void irqAffinityApplierCallback(void* /*context*/) {
         std::string oldVal;
 
         if (readLineFromFile(smpFile, oldVal)) {
-            gIrqAffBackup.emplace_back(smpFile, oldVal);
+            holdIrqAffinity(RES_CODE_IRQ_AFFINITY, smpFile, oldVal, maskStr);
+            count++;
 
-            int rc = writeLineToFile(smpFile, maskStr);
+            int rc = traceWriteLineToFile(TRACE_CB_IRQ_AFFINITY, RES_CODE_IRQ_AFFINITY, smpFile, maskStr);
             if (rc != 0) {
                 logWriteFailure(smpFile, rc);
             }
-            if (rc == 0) {
+            if (rc == 0 && isLogEnabled()) {
                 std::string now;
                 if (readLineFromFile(smpFile, now)) {
-                    logLine("verify " + smpFile + " -> " + now);
+                    RT_LOG("verify {} -> {}", smpFile, now);
                 }
             }
         }
     }
     closedir(dir);
-    gIrqApplied = !gIrqAffBackup.empty();
+    gIrqApplied = count > 0;
+    scope.mResult = count;
 }
 
 static void irqAffinityTearCallback(void* /*context*/) {
     if (!gIrqApplied) return;
-    logLine("enter irqAffinityTearCallback");
+    RT_LOG("enter irqAffinityTearCallback");
+    TraceScope scope(TRACE_EV_TEAR, TRACE_CB_IRQ_AFFINITY, RES_CODE_IRQ_AFFINITY);
 
-    for (const auto& kv : gIrqAffBackup) {
+    // Restores the original value, or the IRQ_AFFINE_ALL mask if still held.
+    std::vector<std::pair<std::string, std::string>> writes;
+    releaseIrqAffinity(RES_CODE_IRQ_AFFINITY, writes);
+    for (const auto& kv : writes) {
         const std::string& path = kv.first;
-        const std::string& oldVal = kv.second;
-        AuxRoutines::writeToFile(path, oldVal);
+        const std::string& val = kv.second;
+        AuxRoutines::writeToFile(path, val);
     }
-    gIrqAffBackup.clear();
     gIrqApplied = false;
 }
 
@@ -223,7 +231,8 @@ static bool gWqApplied = false;
 static std::vector<std::pair<std::string, std::string>> gWqMaskBackup;
 
 static void workqueueApplierCallback(void* /*context*/) {
-    logLine("enter workqueueApplierCallback");
+    RT_LOG("enter workqueueApplierCallback");
+    TraceScope scope(TRACE_EV_APPLY, TRACE_CB_WQ_AFFINITY, RES_CODE_CPU_WQ_AFFINITY);
     if (gWqApplied) return;
 
     gWqMaskBackup.clear();
@@ -245,25 +254,27 @@ static void workqueueApplierCallback(void* /*context*/) {
         if (readLineFromFile(cpumaskFile, oldVal)) {
             gWqMaskBackup.emplace_back(cpumaskFile, oldVal);
 
-            int rc = writeLineToFile(cpumaskFile, maskStr);
+            int rc = traceWriteLineToFile(TRACE_CB_WQ_AFFINITY, RES_CODE_CPU_WQ_AFFINITY, cpumaskFile, maskStr);
             if (rc != 0) {
                 logWriteFailure(cpumaskFile, rc);
             }
-            if (rc == 0) {
+            if (rc == 0 && isLogEnabled()) {
                 std::string now;
                 if (readLineFromFile(cpumaskFile, now)) {
-                    logLine("verify " + cpumaskFile + " -> " + now);
+                    RT_LOG("verify {} -> {}", cpumaskFile, now);
                 }
             }
         }
     }
     closedir(dir);
     gWqApplied = !gWqMaskBackup.empty();
+    scope.mResult = gWqMaskBackup.size();
 }
 
 static void workqueueTearCallback(void* /*context*/) {
     if (!gWqApplied) return;
-    logLine("enter workqueueTearCallback");
+    RT_LOG("enter workqueueTearCallback");
+    TraceScope scope(TRACE_EV_TEAR, TRACE_CB_WQ_AFFINITY, RES_CODE_CPU_WQ_AFFINITY);
 
     for (const auto& kv : gWqMaskBackup) {
         const std::string& path = kv.first;
@@ -275,6 +286,239 @@ static void workqueueTearCallback(void* /*context*/) {
     gWqApplied = false;
 }
 
+// ---------------------------
+// Threaded IRQ / softirq priority: apply/tear
+// ---------------------------
+// One line of IrqThreadConfig.yaml, kernel threads whose comm matches
+// mPattern (fnmatch) are moved to mPolicy / mPriority.
+typedef struct {
+    int32_t mClassId;
+    std::string mPattern;
+    int32_t mPolicy;
+    int32_t mPriority;
+} IrqThreadClass;
+
+// Scheduling settings of one kernel thread.
+typedef struct {
+    std::string mComm;
+    int32_t mPolicy;
+    int32_t mPriority;
+} ThreadSched;
+
+// Guards the state below, config reloads run on the watcher thread.
+static std::mutex gIrqThreadLock;
+static bool gIrqThreadApplied = false;
+static std::vector<int32_t> gIrqThreadClassIds;         // Values of the active request
+static std::map<pid_t, ThreadSched> gIrqThreadBackup;   // Settings before the first change
+static std::map<pid_t, ThreadSched> gIrqThreadSet;      // Settings written by the plugin
+
+static int32_t parseSchedPolicy(const std::string& name) {
+    std::string v = name;
+    toLower(v);
+    if (v == "fifo") return SCHED_FIFO;
+    if (v == "rr") return SCHED_RR;
+    if (v == "other" || v == "normal") return SCHED_OTHER;
+    return -1;
+}
+
+// Entries of the target directory replace generic ones with the same Class.
+static void parseIrqThreadConfig(const std::string& filePath, std::map<int32_t, IrqThreadClass>& classes) {
+    std::ifstream fileStream(filePath, std::ios::in);
+    std::string line;
+    while (fileStream.is_open() && getline(fileStream, line)) {
+        std::string s = trim(line);
+        if (s.empty() || s[0] == '#' || s.find("Pattern:") == std::string::npos) continue;
+
+        IrqThreadClass cls;
+        cls.mClassId = static_cast<int32_t>(strtol(flowField(s, "Class").c_str(), nullptr, 0));
+        cls.mPattern = flowField(s, "Pattern");
+        cls.mPolicy = parseSchedPolicy(flowField(s, "Policy"));
+        cls.mPriority = static_cast<int32_t>(strtol(flowField(s, "Priority").c_str(), nullptr, 0));
+
+        if (cls.mPattern.empty() || cls.mPolicy < 0) {
+            RT_LOG("ignoring irq thread class line: {}", s);
+            continue;
+        }
+        classes[cls.mClassId] = cls;
+    }
+}
+
+static bool readThreadComm(const std::string& tid, std::string& comm) {
+    if (!readLineFromFile(std::string(PROC_DIR_PATH) + tid + "/comm", comm)) return false;
+    comm = trim(comm);
+    return true;
+}
+
+// Requested classes in the order given, the first matching pattern wins.
+static std::vector<IrqThreadClass> loadIrqThreadClasses(const std::vector<int32_t>& ids) {
+    std::map<int32_t, IrqThreadClass> allClasses;
+    std::string machineName;
+    fetchMachineName(machineName);
+    parseIrqThreadConfig(std::string(URM_TARGET_CONFIG_DIR) + IRQ_THREAD_CONFIG_FILE, allClasses);
+    if (!machineName.empty()) {
+        parseIrqThreadConfig(std::string(URM_TARGET_CONFIG_DIR) + machineName + "/" + IRQ_THREAD_CONFIG_FILE,
+                             allClasses);
+    }
+
+    std::vector<IrqThreadClass> classes;
+    for (int32_t id : ids) {
+        if (id < 0) {
+            classes.clear();
+            for (const auto& kv : allClasses) classes.push_back(kv.second);
+            break;
+        }
+        auto it = allClasses.find(id);
+        if (it != allClasses.end()) classes.push_back(it->second);
+    }
+    return classes;
+}
+
+// Kernel threads matching one of the classes and the settings they should get.
+static std::map<pid_t, ThreadSched> matchIrqThreads(const std::vector<IrqThreadClass>& classes) {
+    std::map<pid_t, ThreadSched> wanted;
+    if (classes.empty()) return wanted;
+
+    DIR* dir = opendir(PROC_DIR_PATH);
+    if (!dir) return wanted;
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (!std::isdigit(static_cast<unsigned char>(entry->d_name[0]))) continue;
+
+        std::string comm;
+        if (!readThreadComm(entry->d_name, comm)) continue;
+
+        for (const IrqThreadClass& cls : classes) {
+            if (fnmatch(cls.mPattern.c_str(), comm.c_str(), 0) == 0) {
+                pid_t tid = static_cast<pid_t>(strtol(entry->d_name, nullptr, 10));
+                int32_t prio = (cls.mPolicy == SCHED_OTHER) ? 0 : cls.mPriority;
+                wanted[tid] = {comm, cls.mPolicy, prio};
+                break;
+            }
+        }
+    }
+    closedir(dir);
+    return wanted;
+}
+
+/**
+ * @brief Bring the kernel threads in line with wanted, touching only those
+ *        whose settings differ from what was last written.
+ *
+ * Threads no longer wanted get their original settings back. Called with
+ * gIrqThreadLock held. Returns the number of threads changed.
+ */
+static uint32_t syncIrqThreads(const std::map<pid_t, ThreadSched>& wanted) {
+    uint32_t changed = 0;
+
+    for (auto it = gIrqThreadSet.begin(); it != gIrqThreadSet.end();) {
+        if (wanted.find(it->first) != wanted.end()) {
+            ++it;
+            continue;
+        }
+        // Skip threads which went away and had their tid reused.
+        const ThreadSched& backup = gIrqThreadBackup[it->first];
+        std::string comm;
+        if (readThreadComm(std::to_string(it->first), comm) && comm == backup.mComm) {
+            struct sched_param param{};
+            param.sched_priority = backup.mPriority;
+            if (sched_setscheduler(it->first, backup.mPolicy, &param) != 0) {
+                logSchedFailure(backup.mComm, it->first, backup.mPolicy, backup.mPriority, errno);
+            } else {
+                changed++;
+            }
+        }
+        gIrqThreadBackup.erase(it->first);
+        it = gIrqThreadSet.erase(it);
+    }
+
+    for (const auto& kv : wanted) {
+        pid_t tid = kv.first;
+        const ThreadSched& target = kv.second;
+        auto set = gIrqThreadSet.find(tid);
+        if (set != gIrqThreadSet.end() && set->second.mPolicy == target.mPolicy &&
+            set->second.mPriority == target.mPriority) {
+            continue;
+        }
+
+        if (gIrqThreadBackup.find(tid) == gIrqThreadBackup.end()) {
+            struct sched_param param{};
+            int32_t oldPolicy = sched_getscheduler(tid);
+            if (oldPolicy < 0 || sched_getparam(tid, &param) != 0) continue;
+            gIrqThreadBackup[tid] = {target.mComm, oldPolicy, param.sched_priority};
+        }
+
+        struct sched_param param{};
+        param.sched_priority = target.mPriority;
+        if (sched_setscheduler(tid, target.mPolicy, &param) != 0) {
+            logSchedFailure(target.mComm, tid, target.mPolicy, target.mPriority, errno);
+            if (set == gIrqThreadSet.end()) gIrqThreadBackup.erase(tid);
+            continue;
+        }
+        const ThreadSched& backup = gIrqThreadBackup[tid];
+        RT_LOG("{} ({}): policy {} prio {} -> policy {} prio {}", target.mComm, tid,
+               backup.mPolicy, backup.mPriority, target.mPolicy, target.mPriority);
+        gIrqThreadSet[tid] = target;
+        changed++;
+    }
+    return changed;
+}
+
+// Values: class ids from IrqThreadConfig.yaml to apply, -1 applies all of them.
+static void irqThreadPrioApplierCallback(void* context) {
+    RT_LOG("enter irqThreadPrioApplierCallback");
+    TraceScope scope(TRACE_EV_APPLY, TRACE_CB_IRQ_THREAD_PRIO, RES_CODE_IRQ_THREAD_PRIO);
+
+    const std::lock_guard<std::mutex> lock(gIrqThreadLock);
+    if (gIrqThreadApplied || context == nullptr) return;
+    Resource* resource = static_cast<Resource*>(context);
+
+    // Only PREEMPT_RT force-threads every handler and softirq.
+    if (!isPreemptRtActive()) {
+        RT_LOG("PREEMPT_RT not active, irq thread priorities left unchanged");
+        return;
+    }
+
+    std::vector<int32_t> ids;
+    for (int32_t i = 0; i < resource->getValuesCount(); i++) {
+        ids.push_back(resource->getValueAt(i));
+    }
+    std::vector<IrqThreadClass> classes = loadIrqThreadClasses(ids);
+    if (classes.empty()) return;
+
+    gIrqThreadClassIds = ids;
+    gIrqThreadApplied = true;
+    scope.mResult = syncIrqThreads(matchIrqThreads(classes));
+}
+
+static void irqThreadPrioTearCallback(void* /*context*/) {
+    const std::lock_guard<std::mutex> lock(gIrqThreadLock);
+    if (!gIrqThreadApplied) return;
+    RT_LOG("enter irqThreadPrioTearCallback");
+    TraceScope scope(TRACE_EV_TEAR, TRACE_CB_IRQ_THREAD_PRIO, RES_CODE_IRQ_THREAD_PRIO);
+
+    scope.mResult = syncIrqThreads(std::map<pid_t, ThreadSched>());
+    gIrqThreadBackup.clear();
+    gIrqThreadClassIds.clear();
+    gIrqThreadApplied = false;
+}
+
+// IrqThreadConfig.yaml edited while the resource is held: re-resolve the
+// requested classes and only touch threads whose settings changed.
+static void irqThreadPrioReload() {
+    const std::lock_guard<std::mutex> lock(gIrqThreadLock);
+    if (!gIrqThreadApplied) return;
+    TraceScope scope(TRACE_EV_APPLY, TRACE_CB_IRQ_THREAD_PRIO, RES_CODE_IRQ_THREAD_PRIO);
+
+    scope.mResult = syncIrqThreads(matchIrqThreads(loadIrqThreadClasses(gIrqThreadClassIds)));
+    RT_LOG("{} reloaded, {} threads changed", IRQ_THREAD_CONFIG_FILE, scope.mResult);
+}
+
+__attribute__((constructor))
+static void watchIrqThreadConfig() {
+    watchConfigFile(IRQ_THREAD_CONFIG_FILE, irqThreadPrioReload);
+}
+
 // ---------------------------
 // URM registrations
 // ---------------------------
@@ -283,6 +527,7 @@ static void workqueueTearCallback(void* /*context*/) {
 //   0x00800001 -> cpufreq
 //   0x00800002 -> irqaffinity
 //   0x00800003 -> workqueue
+//   0x00800004 -> irq thread priority
 
 URM_REGISTER_RES_APPLIER_CB(0x00800001, cpufreqGovApplierCallback)
 URM_REGISTER_RES_TEAR_CB   (0x00800001, cpufreqGovTearCallback)
@@ -292,3 +537,6 @@ URM_REGISTER_RES_TEAR_CB   (0x00800002, irqAffinityTearCallback)
 
 URM_REGISTER_RES_APPLIER_CB(0x00800003, workqueueApplierCallback)
 URM_REGISTER_RES_TEAR_CB   (0x00800003, workqueueTearCallback)
+
+URM_REGISTER_RES_APPLIER_CB(0x00800004, irqThreadPrioApplierCallback)
+URM_REGISTER_RES_TEAR_CB   (0x00800004, irqThreadPrioTearCallback)
@@ -0,0 +1,169 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+
+#include "Helpers.h"
+#include "ExtLogger.h"
+#include "ProcExitWatcher.h"
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+#define EXIT_WATCHER_MAX_EVENTS 16
+
+class ProcExitWatcher {
+private:
+    static std::once_flag mInitFlag;
+    static std::unique_ptr<ProcExitWatcher> mInstance;
+
+    std::mutex mLock;
+    int mEpollFd;
+    int mWakeFd;
+    std::thread mThread;
+    // pidfd -> (pid, callbacks)
+    std::map<int, std::pair<pid_t, std::vector<ProcExitCallback>>> mWatched;
+    std::map<pid_t, int> mPidFds;
+
+    void pollLoop();
+    void handleExit(int pidFd);
+
+    ProcExitWatcher();
+    ProcExitWatcher(const ProcExitWatcher&) = delete;
+    ProcExitWatcher& operator=(const ProcExitWatcher&) = delete;
+
+public:
+    static ProcExitWatcher& getInstance() {
+        std::call_once(mInitFlag, [] {
+            mInstance.reset(new ProcExitWatcher());
+        });
+        return *mInstance;
+    }
+
+    ~ProcExitWatcher();
+    int watch(pid_t pid, const ProcExitCallback& onExit);
+};
+
+std::once_flag ProcExitWatcher::mInitFlag;
+std::unique_ptr<ProcExitWatcher> ProcExitWatcher::mInstance = nullptr;
+
+ProcExitWatcher::ProcExitWatcher() : mEpollFd(-1), mWakeFd(-1) {
+    mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    mWakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(mEpollFd < 0 || mWakeFd < 0) {
+        TYPELOGV(ERRNO_LOG, strerror(errno));
+        return;
+    }
+
+    struct epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = mWakeFd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeFd, &ev);
+
+    mThread = std::thread(&ProcExitWatcher::pollLoop, this);
+}
+
+ProcExitWatcher::~ProcExitWatcher() {
+    if(mThread.joinable()) {
+        uint64_t one = 1;
+        ssize_t rc = write(mWakeFd, &one, sizeof(one));
+        (void)rc;
+        mThread.join();
+    }
+
+    for(const auto& kv : mWatched) {
+        close(kv.first);
+    }
+    if(mWakeFd >= 0) close(mWakeFd);
+    if(mEpollFd >= 0) close(mEpollFd);
+}
+
+int ProcExitWatcher::watch(pid_t pid, const ProcExitCallback& onExit) {
+    if(mEpollFd < 0 || !mThread.joinable()) {
+        return ENOSYS;
+    }
+
+    const std::lock_guard<std::mutex> lock(mLock);
+
+    auto it = mPidFds.find(pid);
+    if(it != mPidFds.end()) {
+        mWatched[it->second].second.push_back(onExit);
+        return 0;
+    }
+
+    int pidFd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    if(pidFd < 0) {
+        return errno;
+    }
+
+    struct epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = pidFd;
+    if(epoll_ctl(mEpollFd, EPOLL_CTL_ADD, pidFd, &ev) < 0) {
+        int rc = errno;
+        close(pidFd);
+        return rc;
+    }
+
+    mWatched[pidFd] = std::make_pair(pid, std::vector<ProcExitCallback>{onExit});
+    mPidFds[pid] = pidFd;
+    return 0;
+}
+
+void ProcExitWatcher::handleExit(int pidFd) {
+    pid_t pid = 0;
+    std::vector<ProcExitCallback> callbacks;
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        auto it = mWatched.find(pidFd);
+        if(it == mWatched.end()) {
+            return;
+        }
+        pid = it->second.first;
+        callbacks.swap(it->second.second);
+        mWatched.erase(it);
+        mPidFds.erase(pid);
+
+        epoll_ctl(mEpollFd, EPOLL_CTL_DEL, pidFd, nullptr);
+        close(pidFd);
+    }
+
+    EXT_LOGD("URM_EXT_EXIT", "pid {} exited, {} callbacks", pid, callbacks.size());
+    for(const ProcExitCallback& cb : callbacks) {
+        cb(pid);
+    }
+}
+
+void ProcExitWatcher::pollLoop() {
+    struct epoll_event events[EXIT_WATCHER_MAX_EVENTS];
+    for(;;) {
+        int n = epoll_wait(mEpollFd, events, EXIT_WATCHER_MAX_EVENTS, -1);
+        if(n < 0) {
+            if(errno == EINTR) continue;
+            TYPELOGV(ERRNO_LOG, strerror(errno));
+            return;
+        }
+
+        for(int i = 0; i < n; i++) {
+            if(events[i].data.fd == mWakeFd) {
+                return;
+            }
+            handleExit(events[i].data.fd);
+        }
+    }
+}
+
+int watchProcessExit(pid_t pid, const ProcExitCallback& onExit) {
+    return ProcExitWatcher::getInstance().watch(pid, onExit);
+}
@@ -0,0 +1,254 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdlib>
+#include <algorithm>
+
+#include "SignalTiers.h"
+#include "Tracing.h"
+#include "ExtLogger.h"
+
+// Resource lines of one SignalConfigs entry, keyed by target node.
+typedef std::map<std::string, std::string> TierNodeMap;
+
+typedef struct {
+    uint32_t mSigCode;
+    uint32_t mSigType;
+    bool mHasExtraAttrs;
+    bool mTargetMatch;
+    TierNodeMap mNodes;
+} SignalTierEntry;
+
+class SignalTierRegistry {
+private:
+    static std::once_flag mInitFlag;
+    static std::unique_ptr<SignalTierRegistry> mInstance;
+
+    std::mutex mLock;
+    std::string mMachineName;
+    // sigCode -> sigType -> resources
+    std::map<uint32_t, std::map<uint32_t, TierNodeMap>> mTiers;
+
+    void parseConfigFile(const std::string& filePath);
+    void commitEntry(SignalTierEntry& entry);
+
+    SignalTierRegistry() = default;
+    SignalTierRegistry(const SignalTierRegistry&) = delete;
+    SignalTierRegistry& operator=(const SignalTierRegistry&) = delete;
+
+public:
+    static SignalTierRegistry& getInstance() {
+        std::call_once(mInitFlag, [] {
+            mInstance.reset(new SignalTierRegistry());
+            mInstance->load();
+        });
+        return *mInstance;
+    }
+
+    ~SignalTierRegistry() = default;
+    void load();
+    bool sameNodes(uint32_t sigCode, uint32_t fromType, uint32_t toType);
+    uint32_t resolveTier(uint32_t sigCode, uint32_t sigType);
+};
+
+std::once_flag SignalTierRegistry::mInitFlag;
+std::unique_ptr<SignalTierRegistry> SignalTierRegistry::mInstance = nullptr;
+
+// Cgroup resources carry the cgroup id as their first value, two lines for
+// different cgroups therefore configure different nodes.
+static bool isCgroupResource(const std::string& resCode) {
+    if(resCode.compare(0, 9, "RES_CGRP_") == 0) {
+        return true;
+    }
+    if(resCode.compare(0, 2, "0x") == 0) {
+        uint32_t code = static_cast<uint32_t>(strtoul(resCode.c_str(), nullptr, 16));
+        return ((code >> 16) & 0xff) == 0x09;
+    }
+    return false;
+}
+
+void SignalTierRegistry::commitEntry(SignalTierEntry& entry) {
+    // Variants selected through ExtraAttrs (fps / resolution) are not
+    // tiers of their own, only the plain SigType variants are compared.
+    if(entry.mSigCode != 0 && entry.mTargetMatch && !entry.mHasExtraAttrs) {
+        // Target-specific files are parsed last and override generic ones.
+        mTiers[entry.mSigCode][entry.mSigType] = entry.mNodes;
+    }
+
+    entry.mSigCode = 0;
+    entry.mSigType = DEFAULT_SIGNAL_TYPE;
+    entry.mHasExtraAttrs = false;
+    entry.mTargetMatch = true;
+    entry.mNodes.clear();
+}
+
+void SignalTierRegistry::parseConfigFile(const std::string& filePath) {
+    std::ifstream fileStream(filePath, std::ios::in);
+    if(!fileStream.is_open()) {
+        return;
+    }
+
+    SignalTierEntry entry;
+    uint32_t sigId = 0;
+    uint32_t category = 0;
+    entry.mSigCode = 0;
+    commitEntry(entry);
+
+    std::string line;
+    while(getline(fileStream, line)) {
+        std::string s = trim(line);
+        if(s.empty() || s[0] == '#') {
+            continue;
+        }
+
+        bool listItem = false;
+        if(s.compare(0, 2, "- ") == 0) {
+            listItem = true;
+            s = trim(s.substr(2));
+        }
+
+        if(listItem && s[0] == '{') {
+            std::string resCode = flowField(s, "ResCode");
+            if(resCode.empty()) continue;
+
+            std::vector<std::string> values = splitList(flowField(s, "Values"));
+            std::string nodeKey = resCode + "/" + flowField(s, "ResInfo");
+            size_t firstValue = 0;
+            if(isCgroupResource(resCode) && !values.empty()) {
+                nodeKey += "/" + values[0];
+                firstValue = 1;
+            }
+
+            std::string value;
+            for(size_t i = firstValue; i < values.size(); i++) {
+                if(!value.empty()) value += ",";
+                value += values[i];
+            }
+            entry.mNodes[nodeKey] = value;
+            continue;
+        }
+
+        size_t colon = s.find(':');
+        if(colon == std::string::npos) {
+            continue;
+        }
+        std::string key = trim(s.substr(0, colon));
+        std::string value = stripQuotes(s.substr(colon + 1));
+
+        if(key == "SigId") {
+            commitEntry(entry);
+            sigId = static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 0));
+            category = 0;
+        } else if(key == "Category") {
+            category = static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 0));
+        } else if(key == "SigType" || key == "Type") {
+            entry.mSigType = static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 0));
+        } else if(key == "TargetsEnabled") {
+            std::vector<std::string> targets = splitList(value);
+            entry.mTargetMatch =
+                std::find(targets.begin(), targets.end(), mMachineName) != targets.end();
+        } else if(listItem && (key == "Fps" || key == "Height" || key == "Width")) {
+            entry.mHasExtraAttrs = true;
+        }
+
+        if(sigId != 0 && category != 0) {
+            entry.mSigCode = CONSTRUCT_SIG_CODE(category, sigId);
+        }
+    }
+    commitEntry(entry);
+    fileStream.close();
+}
+
+void SignalTierRegistry::load() {
+    const std::lock_guard<std::mutex> lock(mLock);
+
+    fetchMachineName(mMachineName);
+    mTiers.clear();
+
+    parseConfigFile(std::string(URM_TARGET_CONFIG_DIR) + "SignalsConfig.yaml");
+    if(!mMachineName.empty()) {
+        parseConfigFile(std::string(URM_TARGET_CONFIG_DIR) + mMachineName + "/SignalsConfig.yaml");
+    }
+
+    EXT_LOGI("URM_EXT_TIERS", "Parsed tiers of {} signals", mTiers.size());
+}
+
+bool SignalTierRegistry::sameNodes(uint32_t sigCode, uint32_t fromType, uint32_t toType) {
+    const std::lock_guard<std::mutex> lock(mLock);
+
+    auto sig = mTiers.find(sigCode);
+    if(sig == mTiers.end()) {
+        return false;
+    }
+    auto from = sig->second.find(fromType);
+    auto to = sig->second.find(toType);
+    return from != sig->second.end() && to != sig->second.end() && from->second == to->second;
+}
+
+uint32_t SignalTierRegistry::resolveTier(uint32_t sigCode, uint32_t sigType) {
+    const std::lock_guard<std::mutex> lock(mLock);
+
+    auto sig = mTiers.find(sigCode);
+    if(sig == mTiers.end() || sig->second.empty() || sig->second.count(sigType) > 0) {
+        return sigType;
+    }
+    // Tiers are keyed in ascending order, upper_bound is the first above sigType.
+    auto it = sig->second.upper_bound(sigType);
+    if(it == sig->second.begin()) {
+        return it->first;
+    }
+    return (--it)->first;
+}
+
+uint32_t resolveSignalTier(uint32_t sigCode, uint32_t sigType) {
+    return SignalTierRegistry::getInstance().resolveTier(sigCode, sigType);
+}
+
+int64_t transitionSignal(int64_t handle,
+                         uint32_t sigCode,
+                         uint32_t fromType,
+                         uint32_t toType,
+                         pid_t pid,
+                         uint32_t* extraArgs) {
+    if(fromType == toType) {
+        return handle;
+    }
+
+    if(SignalTierRegistry::getInstance().sameNodes(sigCode, fromType, toType)) {
+        // Both tiers configure the exact same nodes, nothing to do.
+        return handle;
+    }
+
+    // Make before break: the whole new tier is acquired before the old one
+    // is released. Every node of the new tier is written, but none falls
+    // back to its default in between, URM arbitrates nodes held by both
+    // handles while they overlap.
+    int64_t newHandle = 0;
+    {
+        TraceScope scope(TRACE_EV_ACQUIRE, TRACE_CB_TIER_TRANSITION, sigCode);
+        newHandle = acquireSignal(sigCode, toType, pid, pid, SIGNAL_EXTRA_ATTRS_COUNT, extraArgs);
+        scope.mResult = newHandle;
+    }
+    if(newHandle <= 0) {
+        return handle;
+    }
+
+    if(handle > 0) {
+        TraceScope scope(TRACE_EV_RELEASE, TRACE_CB_TIER_TRANSITION, sigCode);
+        scope.mResult = releaseSignal(handle, pid, pid);
+    }
+    return newHandle;
+}
+
+__attribute__((constructor))
+static void loadSignalTiers() {
+    // Tiers only depend on the installed configs, parse them while the
+    // plugin is loaded rather than on the first tier change.
+    SignalTierRegistry::getInstance();
+}
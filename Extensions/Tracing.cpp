@@ -0,0 +1,114 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#include <ctime>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Helpers.h"
+#include "Tracing.h"
+
+#define TRACEFS_MARKER_PATH  "/sys/kernel/tracing/trace_marker"
+#define DEBUGFS_MARKER_PATH  "/sys/kernel/debug/tracing/trace_marker"
+
+#ifdef URM_EXT_HAVE_SDT
+extern "C" {
+unsigned short urm_ext_event_semaphore __attribute__((unused)) __attribute__((section(".probes"))) = 0;
+}
+#endif
+
+std::atomic<bool> gTraceMarkerEnabled(false);
+
+static int gTraceMarkerFd = -1;
+
+static const char* const kTraceEventNames[TRACE_EV_COUNT] = {
+    "apply",
+    "tear",
+    "node_write",
+    "classify",
+    "acquire",
+    "release",
+    "prewarm",
+    "reclaim",
+};
+
+uint64_t traceNowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// FNV-1a of the node path, stable across runs so ids can be mapped back to
+// paths offline.
+uint32_t traceNodeId(const std::string& path) {
+    uint32_t hash = 2166136261u;
+    for(unsigned char c : path) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void traceMarkerWrite(uint32_t kind, uint32_t cbId, uint32_t resCode,
+                      uint32_t nodeId, uint64_t durationNs, int64_t result) {
+    if(gTraceMarkerFd < 0 || kind >= TRACE_EV_COUNT) {
+        return;
+    }
+
+    // trace_marker takes each write() as one event, format into a stack
+    // buffer and hand it over in a single call.
+    char buf[128];
+    int len = snprintf(buf, sizeof(buf),
+                       "urm_ext: ev=%s cb=%u res=0x%08x node=0x%08x dur_ns=%llu ret=%lld\n",
+                       kTraceEventNames[kind], cbId, resCode, nodeId,
+                       static_cast<unsigned long long>(durationNs),
+                       static_cast<long long>(result));
+    if(len <= 0) {
+        return;
+    }
+    if(len > static_cast<int>(sizeof(buf))) {
+        len = sizeof(buf);
+    }
+
+    ssize_t rc = write(gTraceMarkerFd, buf, len);
+    (void)rc;
+}
+
+int traceWriteLineToFile(uint32_t cbId, uint32_t resCode,
+                         const std::string& path, const std::string& value) {
+    TraceScope scope(TRACE_EV_NODE_WRITE, cbId, resCode, path);
+    int rc = writeLineToFile(path, value);
+    scope.mResult = rc;
+    return rc;
+}
+
+__attribute__((constructor))
+static void initTraceMarker() {
+    if(!parseBoolEnv(std::getenv("URM_EXT_TRACE"))) {
+        return;
+    }
+
+    gTraceMarkerFd = open(TRACEFS_MARKER_PATH, O_WRONLY | O_CLOEXEC);
+    if(gTraceMarkerFd < 0) {
+        gTraceMarkerFd = open(DEBUGFS_MARKER_PATH, O_WRONLY | O_CLOEXEC);
+    }
+
+    if(gTraceMarkerFd < 0) {
+        TYPELOGV(ERRNO_LOG, strerror(errno));
+        return;
+    }
+    gTraceMarkerEnabled.store(true, std::memory_order_relaxed);
+}
+
+__attribute__((destructor))
+static void closeTraceMarker() {
+    gTraceMarkerEnabled.store(false, std::memory_order_relaxed);
+    if(gTraceMarkerFd >= 0) {
+        close(gTraceMarkerFd);
+        gTraceMarkerFd = -1;
+    }
+}
@@ -0,0 +1,773 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#include <set>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <sched.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+
+#include "Helpers.h"
+#include "ReplayCore.h"
+
+#define URM_COMMON_CONFIG_DIR   "/etc/urm/common/"
+#define CPUFREQ_POLICY_DIR      "/sys/devices/system/cpu/cpufreq/"
+
+static bool gReplayLogEnabled = false;
+static std::atomic<bool> gRecordWrites(false);
+
+std::once_flag ReplayCore::mInitFlag;
+std::unique_ptr<ReplayCore> ReplayCore::mInstance = nullptr;
+
+uint64_t replayMonoNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+uint64_t replayWallNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void replaySetLogEnabled(bool enabled) {
+    gReplayLogEnabled = enabled;
+}
+
+void replaySetWriteRecording(bool enabled) {
+    gRecordWrites.store(enabled, std::memory_order_release);
+}
+
+void replayLog(char level, const std::string& tag, const std::string& msg) {
+    if(gReplayLogEnabled || level == 'E') {
+        fprintf(stderr, "%c %s: %s\n", level, tag.c_str(), msg.c_str());
+    }
+}
+
+static bool procEntryExists(pid_t pid) {
+    return access(("/proc/" + std::to_string(pid)).c_str(), F_OK) == 0;
+}
+
+static std::string hexCode(uint32_t code) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "0x%08x", code);
+    return buf;
+}
+
+ReplayCore::ReplayCore() : mNextHandle(1), mSkippedResources(0) {
+    mTraceClock = [] { return static_cast<int64_t>(0); };
+}
+
+void ReplayCore::registerResourceCallback(uint32_t resCode, ResourceLifecycleCallback cb, bool tear) {
+    const std::lock_guard<std::mutex> lock(mLock);
+    if(tear) {
+        mTears[resCode] = cb;
+    } else {
+        mAppliers[resCode] = cb;
+    }
+}
+
+void ReplayCore::registerPostProcessCallback(const std::string& procName, PostProcessingCallback cb) {
+    const std::lock_guard<std::mutex> lock(mLock);
+    mPostProcessors[procName] = cb;
+}
+
+void ReplayCore::parseResourcesConfig(const std::string& filePath) {
+    std::ifstream fileStream(filePath, std::ios::in);
+    if(!fileStream.is_open()) {
+        return;
+    }
+
+    uint32_t resType = 0, resId = 0;
+    std::string name, path;
+    bool open = false;
+    auto commit = [&] {
+        if(open) {
+            uint32_t code = (resType << 16) | resId;
+            if(!name.empty()) mResourceCodes[name] = code;
+            mResourcePaths[code] = path;
+        }
+        resType = resId = 0;
+        name.clear();
+        path.clear();
+    };
+
+    std::string line;
+    while(getline(fileStream, line)) {
+        std::string s = trim(line);
+        if(s.empty() || s[0] == '#') {
+            continue;
+        }
+        if(s.compare(0, 2, "- ") == 0) {
+            commit();
+            open = true;
+            s = trim(s.substr(2));
+        }
+
+        size_t colon = s.find(':');
+        if(colon == std::string::npos) {
+            continue;
+        }
+        std::string key = trim(s.substr(0, colon));
+        std::string value = stripQuotes(s.substr(colon + 1));
+        if(key == "ResType") {
+            resType = static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 16));
+        } else if(key == "ResID") {
+            resId = static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 16));
+        } else if(key == "Name") {
+            name = value;
+        } else if(key == "Path") {
+            path = value;
+        }
+    }
+    commit();
+}
+
+// Same line based reading as SignalTiers.cpp. Variants selected through
+// ExtraAttrs are not matched, the first entry of a SigId / SigType pair in
+// a file is used, later files override earlier ones.
+void ReplayCore::parseSignalsConfig(const std::string& filePath, const std::string& machineName) {
+    std::ifstream fileStream(filePath, std::ios::in);
+    if(!fileStream.is_open()) {
+        return;
+    }
+
+    std::set<std::pair<uint32_t, uint32_t>> seen;
+    ReplaySignalConfig config;
+    uint32_t sigId = 0, category = 0, sigType = DEFAULT_SIGNAL_TYPE;
+    bool enabled = true;
+    bool targetMatch = true;
+
+    auto commit = [&] {
+        if(sigId != 0 && category != 0 && enabled && targetMatch) {
+            std::pair<uint32_t, uint32_t> key(CONSTRUCT_SIG_CODE(category, sigId), sigType);
+            if(seen.insert(key).second) {
+                mSignals[key] = config;
+            }
+        }
+        config.mTimeoutMs = -1;
+        config.mResources.clear();
+        sigId = category = 0;
+        sigType = DEFAULT_SIGNAL_TYPE;
+        enabled = targetMatch = true;
+    };
+    commit();
+
+    std::string line;
+    while(getline(fileStream, line)) {
+        std::string s = trim(line);
+        if(s.empty() || s[0] == '#') {
+            continue;
+        }
+
+        bool listItem = false;
+        if(s.compare(0, 2, "- ") == 0) {
+            listItem = true;
+            s = trim(s.substr(2));
+        }
+
+        if(listItem && s[0] == '{') {
+            ReplayResourceLine res;
+            res.mResCode = flowField(s, "ResCode");
+            if(res.mResCode.empty()) continue;
+
+            if(res.mResCode.compare(0, 2, "0x") == 0) {
+                res.mCode = static_cast<uint32_t>(strtoul(res.mResCode.c_str(), nullptr, 16));
+            } else {
+                auto it = mResourceCodes.find(res.mResCode);
+                res.mCode = (it != mResourceCodes.end()) ? it->second : 0;
+            }
+            res.mResInfo = static_cast<uint32_t>(strtoul(flowField(s, "ResInfo").c_str(), nullptr, 16));
+            for(const std::string& v : splitList(flowField(s, "Values"))) {
+                res.mValues.push_back(static_cast<int32_t>(strtol(v.c_str(), nullptr, 0)));
+            }
+            config.mResources.push_back(res);
+            continue;
+        }
+
+        size_t colon = s.find(':');
+        if(colon == std::string::npos) {
+            continue;
+        }
+        std::string key = trim(s.substr(0, colon));
+        std::string value = stripQuotes(s.substr(colon + 1));
+
+        if(key == "SigId") {
+            commit();
+            sigId = static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 0));
+        } else if(key == "Category") {
+            category = static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 0));
+        } else if(key == "SigType" || key == "Type") {
+            sigType = static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 0));
+        } else if(key == "Timeout") {
+            config.mTimeoutMs = strtoll(value.c_str(), nullptr, 0);
+        } else if(key == "Enable") {
+            enabled = (value != "false");
+        } else if(key == "TargetsEnabled") {
+            std::vector<std::string> targets = splitList(value);
+            targetMatch = std::find(targets.begin(), targets.end(), machineName) != targets.end();
+        }
+    }
+    commit();
+}
+
+void ReplayCore::loadConfigs() {
+    const std::lock_guard<std::mutex> lock(mLock);
+
+    std::string machineName;
+    fetchMachineName(machineName);
+
+    // Resource names first, signal lines refer to them by name.
+    const std::string dirs[] = {
+        URM_COMMON_CONFIG_DIR,
+        URM_TARGET_CONFIG_DIR,
+        machineName.empty() ? std::string() : std::string(URM_TARGET_CONFIG_DIR) + machineName + "/",
+    };
+    for(const std::string& dir : dirs) {
+        if(!dir.empty()) parseResourcesConfig(dir + "ResourcesConfig.yaml");
+    }
+    for(const std::string& dir : dirs) {
+        if(!dir.empty()) parseSignalsConfig(dir + "SignalsConfig.yaml", machineName);
+    }
+
+    replayLog('I', "URM_REPLAY", "machine '" + machineName + "': " +
+              std::to_string(mResourceCodes.size()) + " resources, " +
+              std::to_string(mSignals.size()) + " signals");
+}
+
+void ReplayCore::setTraceClock(const std::function<int64_t()>& clock) {
+    const std::lock_guard<std::mutex> lock(mLock);
+    mTraceClock = clock;
+}
+
+void ReplayCore::recordEffect(const std::string& what) {
+    const std::lock_guard<std::mutex> lock(mLock);
+    mEffects.push_back({replayMonoNs(), what});
+    mChanged.notify_all();
+}
+
+bool ReplayCore::hasPostProcessor(const std::string& procName) {
+    const std::lock_guard<std::mutex> lock(mLock);
+    return mPostProcessors.find(procName) != mPostProcessors.end();
+}
+
+int64_t ReplayCore::launch(pid_t pid, const std::string& procName, uint32_t sigCode, uint32_t sigType) {
+    PostProcessingCallback cb = nullptr;
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        auto it = mPostProcessors.find(procName);
+        if(it != mPostProcessors.end()) cb = it->second;
+    }
+
+    PostProcessCBData data = {pid, sigCode, sigType, 0};
+    if(cb != nullptr) {
+        cb(&data);
+    }
+
+    // Callbacks which acquire on their own hand the handle back and keep
+    // ownership of it, otherwise the core acquires the (possibly updated)
+    // signal and holds it until the process exits.
+    if(data.mHandleAcq != 0) {
+        return data.mHandleAcq;
+    }
+    if(data.mSigId == 0) {
+        return 0;
+    }
+
+    int64_t handle = acquire(data.mSigId, data.mSigType, pid);
+    if(handle > 0) {
+        const std::lock_guard<std::mutex> lock(mLock);
+        mLaunchHandles[pid].push_back(handle);
+    }
+    return handle;
+}
+
+void ReplayCore::processExited(pid_t pid) {
+    std::vector<ProcExitCallback> callbacks;
+    std::vector<int64_t> handles;
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        auto it = mExitWatchers.find(pid);
+        if(it != mExitWatchers.end()) {
+            callbacks.swap(it->second);
+            mExitWatchers.erase(it);
+        }
+        auto hit = mLaunchHandles.find(pid);
+        if(hit != mLaunchHandles.end()) {
+            handles.swap(hit->second);
+            mLaunchHandles.erase(hit);
+        }
+    }
+
+    for(const ProcExitCallback& cb : callbacks) {
+        cb(pid);
+    }
+    for(int64_t handle : handles) {
+        release(handle);
+    }
+}
+
+void ReplayCore::applyResource(int64_t handle, const ReplayResourceLine& line, ReplayHandle& entry) {
+    ResourceLifecycleCallback cb = nullptr;
+    std::string path;
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        auto it = mAppliers.find(line.mCode);
+        if(it != mAppliers.end()) cb = it->second;
+        auto pit = mResourcePaths.find(line.mCode);
+        if(pit != mResourcePaths.end()) path = pit->second;
+    }
+
+    if(cb != nullptr) {
+        std::shared_ptr<Resource> resource(new Resource(line.mCode, line.mResInfo, line.mValues));
+        cb(resource.get());
+        entry.mApplied.push_back({line.mCode, resource, ""});
+        return;
+    }
+
+    // Core resources (names from the URM common configs, per cluster or
+    // per cgroup paths) are not modelled.
+    if(line.mCode == 0 || path.empty() || path.find('%') != std::string::npos || line.mValues.empty()) {
+        const std::lock_guard<std::mutex> lock(mLock);
+        mSkippedResources++;
+        return;
+    }
+
+    std::string value = std::to_string(line.mValues[0]);
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        if(mNodeOriginal.find(path) == mNodeOriginal.end()) {
+            std::string original;
+            readLineFromFile(path, original);
+            mNodeOriginal[path] = trim(original);
+        }
+        mNodeHolders[path].push_back(std::make_pair(handle, value));
+    }
+    writeLineToFile(path, value);
+    entry.mApplied.push_back({line.mCode, nullptr, path});
+}
+
+void ReplayCore::tearResources(int64_t handle, ReplayHandle& entry) {
+    for(auto it = entry.mApplied.rbegin(); it != entry.mApplied.rend(); ++it) {
+        if(it->mResource) {
+            ResourceLifecycleCallback cb = nullptr;
+            {
+                const std::lock_guard<std::mutex> lock(mLock);
+                auto cit = mTears.find(it->mCode);
+                if(cit != mTears.end()) cb = cit->second;
+            }
+            if(cb != nullptr) {
+                cb(it->mResource.get());
+            }
+            continue;
+        }
+
+        std::string value;
+        {
+            const std::lock_guard<std::mutex> lock(mLock);
+            std::vector<std::pair<int64_t, std::string>>& holders = mNodeHolders[it->mPath];
+            holders.erase(std::remove_if(holders.begin(), holders.end(),
+                                         [handle](const std::pair<int64_t, std::string>& h) {
+                                             return h.first == handle;
+                                         }),
+                          holders.end());
+            if(holders.empty()) {
+                value = mNodeOriginal[it->mPath];
+                mNodeHolders.erase(it->mPath);
+                mNodeOriginal.erase(it->mPath);
+            } else {
+                value = holders.back().second;
+            }
+        }
+        writeLineToFile(it->mPath, value);
+    }
+    entry.mApplied.clear();
+}
+
+int64_t ReplayCore::acquire(uint32_t sigCode, uint32_t sigType, pid_t pid) {
+    ReplaySignalConfig config;
+    int64_t handle = 0;
+    int64_t now = 0;
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        auto it = mSignals.find(std::make_pair(sigCode, sigType));
+        if(it == mSignals.end()) {
+            it = mSignals.find(std::make_pair(sigCode, static_cast<uint32_t>(DEFAULT_SIGNAL_TYPE)));
+        }
+        if(it == mSignals.end()) {
+            mEffects.push_back({replayMonoNs(), "acquire " + hexCode(sigCode) + "/" +
+                                std::to_string(sigType) + " unknown"});
+            return -1;
+        }
+        config = it->second;
+        handle = mNextHandle++;
+        now = mTraceClock();
+    }
+
+    ReplayHandle entry;
+    entry.mSigCode = sigCode;
+    entry.mSigType = sigType;
+    entry.mPid = pid;
+    entry.mDeadlineMs = config.mTimeoutMs > 0 ? now + config.mTimeoutMs : -1;
+    for(const ReplayResourceLine& line : config.mResources) {
+        applyResource(handle, line, entry);
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        mHandles[handle] = entry;
+    }
+    recordEffect("acquire " + hexCode(sigCode) + "/" + std::to_string(sigType) +
+                 " h" + std::to_string(handle));
+    return handle;
+}
+
+int8_t ReplayCore::release(int64_t handle) {
+    ReplayHandle entry;
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        auto it = mHandles.find(handle);
+        if(it == mHandles.end()) {
+            return -1;
+        }
+        entry = it->second;
+        mHandles.erase(it);
+    }
+
+    tearResources(handle, entry);
+    recordEffect("release " + hexCode(entry.mSigCode) + "/" + std::to_string(entry.mSigType) +
+                 " h" + std::to_string(handle));
+    return 0;
+}
+
+uint32_t ReplayCore::expire(int64_t traceNowMs) {
+    std::vector<int64_t> expired;
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        for(const auto& kv : mHandles) {
+            if(kv.second.mDeadlineMs >= 0 && kv.second.mDeadlineMs <= traceNowMs) {
+                expired.push_back(kv.first);
+            }
+        }
+    }
+
+    uint32_t count = 0;
+    for(int64_t handle : expired) {
+        if(release(handle) == 0) count++;
+    }
+    return count;
+}
+
+int64_t ReplayCore::nextDeadline() {
+    const std::lock_guard<std::mutex> lock(mLock);
+    int64_t next = -1;
+    for(const auto& kv : mHandles) {
+        int64_t d = kv.second.mDeadlineMs;
+        if(d >= 0 && (next < 0 || d < next)) next = d;
+    }
+    return next;
+}
+
+void ReplayCore::waitForChange(uint64_t monoDeadlineNs) {
+    std::unique_lock<std::mutex> lock(mLock);
+    // steady_clock is CLOCK_MONOTONIC on Linux.
+    std::chrono::steady_clock::time_point deadline{
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::nanoseconds(monoDeadlineNs))};
+    mChanged.wait_until(lock, deadline);
+}
+
+int ReplayCore::watchExit(pid_t pid, const ProcExitCallback& onExit) {
+    if(!procEntryExists(pid)) {
+        return ESRCH;
+    }
+    const std::lock_guard<std::mutex> lock(mLock);
+    mExitWatchers[pid].push_back(onExit);
+    return 0;
+}
+
+int ReplayCore::setScheduler(pid_t tid, int32_t policy, int32_t priority, bool record) {
+    if(!procEntryExists(tid)) {
+        return ESRCH;
+    }
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        mSched[tid] = std::make_pair(policy, priority);
+    }
+    if(!record) {
+        return 0;
+    }
+    recordEffect("sched " + std::to_string(tid) + " " + std::to_string(policy) +
+                 "/" + std::to_string(priority));
+    return 0;
+}
+
+bool ReplayCore::getScheduler(pid_t tid, int32_t& policy, int32_t& priority) {
+    if(!procEntryExists(tid)) {
+        return false;
+    }
+    const std::lock_guard<std::mutex> lock(mLock);
+    auto it = mSched.find(tid);
+    policy = (it != mSched.end()) ? it->second.first : SCHED_OTHER;
+    priority = (it != mSched.end()) ? it->second.second : 0;
+    return true;
+}
+
+std::map<pid_t, std::pair<int32_t, int32_t>> ReplayCore::schedState() {
+    const std::lock_guard<std::mutex> lock(mLock);
+    return mSched;
+}
+
+std::vector<ReplayEffect> ReplayCore::takeEffects() {
+    const std::lock_guard<std::mutex> lock(mLock);
+    std::vector<ReplayEffect> effects;
+    effects.swap(mEffects);
+    return effects;
+}
+
+void ReplayCore::recordWrite(const char* path) {
+    const std::lock_guard<std::mutex> lock(mWriteLock);
+    mWrites.push_back({replayMonoNs(), path});
+}
+
+std::vector<ReplayWrite> ReplayCore::takeWrites() {
+    const std::lock_guard<std::mutex> lock(mWriteLock);
+    std::vector<ReplayWrite> writes;
+    writes.swap(mWrites);
+    return writes;
+}
+
+uint32_t ReplayCore::takeSkippedResources() {
+    const std::lock_guard<std::mutex> lock(mLock);
+    uint32_t skipped = mSkippedResources;
+    mSkippedResources = 0;
+    return skipped;
+}
+
+size_t ReplayCore::activeHandles() {
+    const std::lock_guard<std::mutex> lock(mLock);
+    return mHandles.size();
+}
+
+std::vector<uint32_t> ReplayCore::heldSigTypes(uint32_t sigCode) {
+    std::vector<uint32_t> types;
+    {
+        const std::lock_guard<std::mutex> lock(mLock);
+        for(const auto& kv : mHandles) {
+            if(kv.second.mSigCode == sigCode) {
+                types.push_back(kv.second.mSigType);
+            }
+        }
+    }
+    std::sort(types.begin(), types.end());
+    return types;
+}
+
+// URM core entry points used by the plugin sources.
+
+int32_t replayRegisterResourceCallback(uint32_t resCode, ResourceLifecycleCallback cb, bool tear) {
+    ReplayCore::getInstance().registerResourceCallback(resCode, cb, tear);
+    return 0;
+}
+
+int32_t replayRegisterPostProcessCallback(const char* procName, PostProcessingCallback cb) {
+    ReplayCore::getInstance().registerPostProcessCallback(procName, cb);
+    return 0;
+}
+
+int64_t acquireSignal(uint32_t sigCode, uint32_t sigType, pid_t pid, pid_t /*tid*/,
+                      int32_t /*numArgs*/, uint32_t* /*extraArgs*/) {
+    return ReplayCore::getInstance().acquire(sigCode, sigType, pid);
+}
+
+int8_t releaseSignal(int64_t handle, pid_t /*pid*/, pid_t /*tid*/) {
+    return ReplayCore::getInstance().release(handle);
+}
+
+bool AuxRoutines::fileExists(const std::string& path) {
+    return access(path.c_str(), F_OK) == 0;
+}
+
+std::string AuxRoutines::readFromFile(const std::string& path) {
+    std::string line;
+    readLineFromFile(path, line);
+    return trim(line);
+}
+
+void AuxRoutines::writeToFile(const std::string& path, const std::string& value) {
+    writeLineToFile(path, value);
+}
+
+// Mask of the cluster with the highest cpuinfo_max_freq.
+uint64_t GET_TARGET_INFO(int32_t query, int32_t numArgs, int32_t* args) {
+    if(query != GET_MASK || numArgs < 1 || args == nullptr || args[0] != GET_MAX_CLUSTER) {
+        return 0;
+    }
+
+    DIR* dir = opendir(CPUFREQ_POLICY_DIR);
+    if(dir == nullptr) {
+        return 0;
+    }
+
+    uint64_t bestFreq = 0, bestMask = 0;
+    struct dirent* entry;
+    while((entry = readdir(dir)) != nullptr) {
+        if(std::string(entry->d_name).compare(0, 6, "policy") != 0) continue;
+
+        std::string policyDir = std::string(CPUFREQ_POLICY_DIR) + entry->d_name + "/";
+        std::string freq, cpus;
+        if(!readLineFromFile(policyDir + "cpuinfo_max_freq", freq) ||
+           !readLineFromFile(policyDir + "related_cpus", cpus)) {
+            continue;
+        }
+
+        uint64_t mask = 0;
+        std::istringstream iss(cpus);
+        uint32_t cpu = 0;
+        while(iss >> cpu) {
+            if(cpu < 64) mask |= (1ULL << cpu);
+        }
+        uint64_t f = strtoull(freq.c_str(), nullptr, 10);
+        if(f > bestFreq) {
+            bestFreq = f;
+            bestMask = mask;
+        }
+    }
+    closedir(dir);
+    return bestMask;
+}
+
+// pidfds and real scheduler calls would reach host processes, the replay
+// keeps both inside the synthetic tree. open() and fopen() are wrapped to
+// record node writes as they happen: file mtimes come from the coarse clock
+// and miss a same-size rewrite within one tick.
+
+int watchProcessExit(pid_t pid, const ProcExitCallback& onExit) {
+    return ReplayCore::getInstance().watchExit(pid, onExit);
+}
+
+extern "C" {
+
+int sched_setscheduler(pid_t pid, int policy, const struct sched_param* param) __THROW {
+    if(pid == 0 || param == nullptr) {
+        return static_cast<int>(syscall(SYS_sched_setscheduler, pid, policy, param));
+    }
+    int rc = ReplayCore::getInstance().setScheduler(pid, policy & ~SCHED_RESET_ON_FORK,
+                                                    param->sched_priority);
+    if(rc != 0) {
+        errno = rc;
+        return -1;
+    }
+    return 0;
+}
+
+int sched_getscheduler(pid_t pid) __THROW {
+    if(pid == 0) {
+        return static_cast<int>(syscall(SYS_sched_getscheduler, pid));
+    }
+    int32_t policy = 0, priority = 0;
+    if(!ReplayCore::getInstance().getScheduler(pid, policy, priority)) {
+        errno = ESRCH;
+        return -1;
+    }
+    return policy;
+}
+
+int sched_getparam(pid_t pid, struct sched_param* param) __THROW {
+    if(pid == 0 || param == nullptr) {
+        return static_cast<int>(syscall(SYS_sched_getparam, pid, param));
+    }
+    int32_t policy = 0, priority = 0;
+    if(!ReplayCore::getInstance().getScheduler(pid, policy, priority)) {
+        errno = ESRCH;
+        return -1;
+    }
+    param->sched_priority = priority;
+    return 0;
+}
+
+static bool opensForWrite(int flags) {
+    return (flags & O_ACCMODE) != O_RDONLY || (flags & O_TRUNC) != 0;
+}
+
+static void recordOpen(const char* path) {
+    if(path != nullptr && path[0] == '/' && gRecordWrites.load(std::memory_order_acquire)) {
+        ReplayCore::getInstance().recordWrite(path);
+    }
+}
+
+static mode_t openMode(int flags, va_list args) {
+    if((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE) {
+        return static_cast<mode_t>(va_arg(args, int));
+    }
+    return 0;
+}
+
+int open(const char* path, int flags, ...) {
+    va_list args;
+    va_start(args, flags);
+    mode_t mode = openMode(flags, args);
+    va_end(args);
+    int fd = static_cast<int>(syscall(SYS_openat, AT_FDCWD, path, flags, mode));
+    if(fd >= 0 && opensForWrite(flags)) recordOpen(path);
+    return fd;
+}
+
+int open64(const char* path, int flags, ...) {
+    va_list args;
+    va_start(args, flags);
+    mode_t mode = openMode(flags, args);
+    va_end(args);
+    int fd = static_cast<int>(syscall(SYS_openat, AT_FDCWD, path, flags | O_LARGEFILE, mode));
+    if(fd >= 0 && opensForWrite(flags)) recordOpen(path);
+    return fd;
+}
+
+int openat(int dirFd, const char* path, int flags, ...) {
+    va_list args;
+    va_start(args, flags);
+    mode_t mode = openMode(flags, args);
+    va_end(args);
+    int fd = static_cast<int>(syscall(SYS_openat, dirFd, path, flags, mode));
+    if(fd >= 0 && opensForWrite(flags)) recordOpen(path);
+    return fd;
+}
+
+// std::ofstream goes through fopen64().
+typedef FILE* (*FopenFn)(const char*, const char*);
+
+static FILE* fopenAndRecord(const char* name, const char* path, const char* mode) {
+    FopenFn real = reinterpret_cast<FopenFn>(dlsym(RTLD_NEXT, name));
+    if(real == nullptr) {
+        errno = ENOSYS;
+        return nullptr;
+    }
+    FILE* file = real(path, mode);
+    if(file != nullptr && mode != nullptr && strpbrk(mode, "wa+") != nullptr) {
+        recordOpen(path);
+    }
+    return file;
+}
+
+FILE* fopen(const char* path, const char* mode) {
+    return fopenAndRecord("fopen", path, mode);
+}
+
+FILE* fopen64(const char* path, const char* mode) {
+    return fopenAndRecord("fopen64", path, mode);
+}
+
+}
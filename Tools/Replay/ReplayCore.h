@@ -0,0 +1,163 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_REPLAY_CORE_H
+#define URM_REPLAY_CORE_H
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+#include <sys/types.h>
+
+#include <Urm/Resource.h>
+#include <Urm/Extensions.h>
+
+#include "ProcExitWatcher.h"
+
+// Side effect of the plugin observed by the core stand-in.
+typedef struct {
+    uint64_t    mMonoNs;    // CLOCK_MONOTONIC
+    std::string mWhat;
+} ReplayEffect;
+
+// File opened for writing through open() / fopen(), see the interposers in
+// ReplayCore.cpp. Recorded at open time, so the value is read afterwards.
+typedef struct {
+    uint64_t    mMonoNs;
+    std::string mPath;
+} ReplayWrite;
+
+typedef struct {
+    std::string          mResCode;  // As written in SignalsConfig.yaml
+    uint32_t             mCode;     // 0 if the name is unknown to the replay
+    uint32_t             mResInfo;
+    std::vector<int32_t> mValues;
+} ReplayResourceLine;
+
+typedef struct {
+    int64_t mTimeoutMs;             // <= 0 holds the signal until release
+    std::vector<ReplayResourceLine> mResources;
+} ReplaySignalConfig;
+
+// Resource held by an active handle, in apply order.
+typedef struct {
+    uint32_t    mCode;
+    std::shared_ptr<Resource> mResource;    // Set for callback resources
+    std::string mPath;                      // Set for plain node resources
+} ReplayAppliedResource;
+
+typedef struct {
+    uint32_t mSigCode;
+    uint32_t mSigType;
+    pid_t    mPid;
+    int64_t  mDeadlineMs;           // Trace time, -1 if not timed
+    std::vector<ReplayAppliedResource> mApplied;
+} ReplayHandle;
+
+/**
+ * @brief Stand-in for the parts of the URM core the plugin talks to.
+ *
+ * Holds the registered callbacks, resolves signals against the
+ * SignalsConfig.yaml / ResourcesConfig.yaml files of the synthetic tree and
+ * applies their resources either through the plugin callbacks or by writing
+ * the configured node, the way the URM core would. All paths are relative
+ * to the replay root, which the replay process has already chrooted into.
+ */
+class ReplayCore {
+private:
+    static std::once_flag mInitFlag;
+    static std::unique_ptr<ReplayCore> mInstance;
+
+    std::mutex mLock;
+    std::condition_variable mChanged;
+
+    std::map<uint32_t, ResourceLifecycleCallback> mAppliers;
+    std::map<uint32_t, ResourceLifecycleCallback> mTears;
+    std::map<std::string, PostProcessingCallback> mPostProcessors;
+
+    std::map<std::string, uint32_t> mResourceCodes;     // Name -> code
+    std::map<uint32_t, std::string> mResourcePaths;     // Code -> node
+    std::map<std::pair<uint32_t, uint32_t>, ReplaySignalConfig> mSignals;
+
+    int64_t mNextHandle;
+    std::map<int64_t, ReplayHandle> mHandles;
+    std::map<pid_t, std::vector<int64_t>> mLaunchHandles;   // Acquired for exec events
+
+    // Per node, the value to restore and the values of the handles holding
+    // it, the latest request wins.
+    std::map<std::string, std::string> mNodeOriginal;
+    std::map<std::string, std::vector<std::pair<int64_t, std::string>>> mNodeHolders;
+
+    std::map<pid_t, std::vector<ProcExitCallback>> mExitWatchers;
+    std::map<pid_t, std::pair<int32_t, int32_t>> mSched;    // tid -> (policy, priority)
+
+    std::vector<ReplayEffect> mEffects;
+    std::mutex mWriteLock;                  // Taken while mLock may be held
+    std::vector<ReplayWrite> mWrites;
+    uint32_t mSkippedResources;
+    std::function<int64_t()> mTraceClock;
+
+    void parseResourcesConfig(const std::string& filePath);
+    void parseSignalsConfig(const std::string& filePath, const std::string& machineName);
+    void applyResource(int64_t handle, const ReplayResourceLine& line, ReplayHandle& entry);
+    void tearResources(int64_t handle, ReplayHandle& entry);
+    void recordEffect(const std::string& what);
+
+    ReplayCore();
+    ReplayCore(const ReplayCore&) = delete;
+    ReplayCore& operator=(const ReplayCore&) = delete;
+
+public:
+    static ReplayCore& getInstance() {
+        std::call_once(mInitFlag, [] {
+            mInstance.reset(new ReplayCore());
+        });
+        return *mInstance;
+    }
+
+    void registerResourceCallback(uint32_t resCode, ResourceLifecycleCallback cb, bool tear);
+    void registerPostProcessCallback(const std::string& procName, PostProcessingCallback cb);
+
+    // Reads the common, target and machine specific configs under /etc/urm.
+    void loadConfigs();
+    void setTraceClock(const std::function<int64_t()>& clock);
+
+    bool    hasPostProcessor(const std::string& procName);
+    int64_t launch(pid_t pid, const std::string& procName, uint32_t sigCode, uint32_t sigType);
+    void    processExited(pid_t pid);
+
+    int64_t acquire(uint32_t sigCode, uint32_t sigType, pid_t pid);
+    int8_t  release(int64_t handle);
+
+    // Tears every timed handle whose deadline is at or before traceNowMs,
+    // returns the number of handles torn.
+    uint32_t expire(int64_t traceNowMs);
+    int64_t  nextDeadline();
+    void     waitForChange(uint64_t monoDeadlineNs);
+
+    int  watchExit(pid_t pid, const ProcExitCallback& onExit);
+    int  setScheduler(pid_t tid, int32_t policy, int32_t priority, bool record = true);
+    bool getScheduler(pid_t tid, int32_t& policy, int32_t& priority);
+    std::map<pid_t, std::pair<int32_t, int32_t>> schedState();
+
+    std::vector<ReplayEffect> takeEffects();
+    void recordWrite(const char* path);
+    std::vector<ReplayWrite> takeWrites();
+    uint32_t takeSkippedResources();
+    size_t   activeHandles();
+    // SigTypes of the active handles of sigCode, in ascending order.
+    std::vector<uint32_t> heldSigTypes(uint32_t sigCode);
+};
+
+uint64_t replayMonoNs();     // Pacing and latencies
+uint64_t replayWallNs();     // CLOCK_REALTIME, only to compare with file mtimes
+void     replaySetLogEnabled(bool enabled);
+// Node writes are recorded only once the replay is inside its root.
+void     replaySetWriteRecording(bool enabled);
+
+#endif
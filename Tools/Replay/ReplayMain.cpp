@@ -0,0 +1,932 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+// urm-ext-replay: drives the plugin callbacks from a recorded event trace
+// against a synthetic /proc and /sys tree, see docs/12-replay-tool.md.
+
+#include <map>
+#include <set>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "Helpers.h"
+#include "ReplayCore.h"
+#include "ReplayRoot.h"
+
+#ifndef URM_REPLAY_DEFAULT_PLUGIN
+#define URM_REPLAY_DEFAULT_PLUGIN   "UrmPluginReplay.so"
+#endif
+#ifndef URM_REPLAY_DEFAULT_CONFIGS
+#define URM_REPLAY_DEFAULT_CONFIGS  "Configs"
+#endif
+
+#define REPLAY_PLUGIN_INSTALL_DIR   "/usr/lib/urm"
+#define REPLAY_PLUGIN_INSTALL_PATH  REPLAY_PLUGIN_INSTALL_DIR "/UrmPlugin.so"
+#define REPLAY_DEFAULT_SETTLE_MS    50
+#define REPLAY_COMM_LEN             15
+
+enum ReplayEventKind {
+    EV_EXEC = 0,
+    EV_EXIT,
+    EV_ACQUIRE,
+    EV_RELEASE,
+    EV_NODE,
+    EV_SCHED,
+    EV_EXPECT,
+};
+
+typedef struct {
+    int64_t         mTimeMs;
+    ReplayEventKind mKind;
+    uint32_t        mLine;
+    pid_t           mPid;           // exec, exit, acquire, sched (tid)
+    std::string     mComm;
+    std::string     mCwd;
+    std::vector<std::string> mArgv;
+    std::vector<std::pair<pid_t, std::string>> mThreads;
+    uint32_t        mSigCode;
+    uint32_t        mSigType;
+    std::string     mAlias;         // acquire / release
+    std::string     mPath;          // node
+    std::string     mValue;         // node
+    int32_t         mPolicy;        // sched
+    int32_t         mPriority;      // sched
+    size_t          mExpect;        // expect, index into the expectations
+} ReplayEvent;
+
+typedef struct {
+    std::string mPath;
+    std::string mValue;
+    uint32_t    mLine;
+    int64_t     mTimeMs;            // -1 checks the final state
+    bool        mFound;             // Observed value of a timed expectation
+    std::string mGot;
+} ReplayExpect;
+
+typedef struct {
+    int64_t     mTimeMs;
+    std::string mLabel;
+    uint64_t    mStartNs;           // CLOCK_MONOTONIC at dispatch
+    uint64_t    mStartWallNs;       // CLOCK_REALTIME at dispatch, for file mtimes
+    uint64_t    mCbNs;
+    uint64_t    mE2eNs;
+    uint32_t    mWrites;
+    uint32_t    mAcquires;
+    uint32_t    mReleases;
+    uint32_t    mSchedChanges;
+    uint32_t    mSkipped;
+    std::vector<std::string> mDetails;
+} ReplayResult;
+
+typedef struct {
+    std::string mRoot;
+    std::string mTrace;
+    std::string mPlugin;
+    std::string mConfigs;
+    std::string mWorkDir;
+    double      mSpeed;
+    uint32_t    mSettleMs;
+    bool        mKeep;
+    bool        mVerbose;
+} ReplayOptions;
+
+static std::atomic<int64_t> gTraceNowMs(0);
+static uint64_t gStartNs = 0;       // CLOCK_MONOTONIC
+static double gSpeed = 1.0;
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s --root DIR --trace FILE [options]\n"
+            "  --root DIR       synthetic tree (proc/, sys/, optionally etc/urm/), copied before the run\n"
+            "  --trace FILE     event trace\n"
+            "  --speed X        trace time per wall time, 0 replays back to back (default 1)\n"
+            "  --settle-ms N    wait for async work after each event when --speed is 0,\n"
+            "                   and after the last event (default %d)\n"
+            "  --plugin PATH    plugin built by the replay target (default %s)\n"
+            "  --configs DIR    configs seeded when the root has no etc/urm/target (default %s)\n"
+            "  --work DIR       working copy location (default: fresh directory under /tmp)\n"
+            "  --keep           keep the working copy\n"
+            "  -v               per node detail and plugin logs\n",
+            argv0, REPLAY_DEFAULT_SETTLE_MS, URM_REPLAY_DEFAULT_PLUGIN, URM_REPLAY_DEFAULT_CONFIGS);
+}
+
+// Whitespace separated tokens, single and double quotes group, '#' starts
+// a comment outside quotes.
+static std::vector<std::string> tokenize(const std::string& line) {
+    std::vector<std::string> tokens;
+    std::string token;
+    bool inToken = false;
+    char quote = 0;
+
+    for(size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if(quote != 0) {
+            if(c == quote) {
+                quote = 0;
+            } else if(c == '\\' && quote == '"' && i + 1 < line.size()) {
+                token.push_back(line[++i]);
+            } else {
+                token.push_back(c);
+            }
+            continue;
+        }
+        if(c == '"' || c == '\'') {
+            quote = c;
+            inToken = true;
+        } else if(std::isspace(static_cast<unsigned char>(c))) {
+            if(inToken) tokens.push_back(token);
+            token.clear();
+            inToken = false;
+        } else if(c == '#' && !inToken) {
+            break;
+        } else {
+            token.push_back(c);
+            inToken = true;
+        }
+    }
+    if(inToken) tokens.push_back(token);
+    return tokens;
+}
+
+static bool parseNumber(const std::string& s, int64_t& value) {
+    if(s.empty()) return false;
+    char* end = nullptr;
+    errno = 0;
+    value = strtoll(s.c_str(), &end, 0);
+    return errno == 0 && end != nullptr && *end == '\0';
+}
+
+static bool parsePolicy(const std::string& s, int32_t& policy) {
+    if(s == "other" || s == "normal") policy = SCHED_OTHER;
+    else if(s == "fifo") policy = SCHED_FIFO;
+    else if(s == "rr") policy = SCHED_RR;
+    else if(s == "batch") policy = SCHED_BATCH;
+    else if(s == "idle") policy = SCHED_IDLE;
+    else return false;
+    return true;
+}
+
+static std::string policyName(int32_t policy) {
+    switch(policy) {
+        case SCHED_OTHER: return "other";
+        case SCHED_FIFO:  return "fifo";
+        case SCHED_RR:    return "rr";
+        case SCHED_BATCH: return "batch";
+        case SCHED_IDLE:  return "idle";
+        default:          return std::to_string(policy);
+    }
+}
+
+static std::string joinTokens(const std::vector<std::string>& tokens, size_t from) {
+    std::string s;
+    for(size_t i = from; i < tokens.size(); i++) {
+        if(i > from) s += " ";
+        s += tokens[i];
+    }
+    return s;
+}
+
+static std::string baseName(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+/**
+ * @brief Parse the trace, one event per line:
+ *
+ *   <t_ms> exec <pid> [comm=] [cwd=] [threads=tid:comm,..] [sig=] [type=] -- <argv..>
+ *   <t_ms> exit <pid>
+ *   <t_ms> acquire <alias> sig=<code> [type=] [pid=]
+ *   <t_ms> release <alias>
+ *   <t_ms> node <path> <value..>
+ *   <t_ms> sched <tid> <policy> <priority>
+ *   [<t_ms>] expect <path> <value..>
+ *   [<t_ms>] expect sched:<tid> <policy>/<priority>
+ *   [<t_ms>] expect signal:<code> <sigType>,..
+ *
+ * Expectations without a time are checked against the final state.
+ */
+static bool parseTrace(const std::string& filePath,
+                       std::vector<ReplayEvent>& events,
+                       std::vector<ReplayExpect>& expects) {
+    std::ifstream fileStream(filePath, std::ios::in);
+    if(!fileStream.is_open()) {
+        fprintf(stderr, "%s: %s\n", filePath.c_str(), strerror(errno));
+        return false;
+    }
+
+    std::string line;
+    uint32_t lineNo = 0;
+    while(getline(fileStream, line)) {
+        lineNo++;
+        std::vector<std::string> tokens = tokenize(line);
+        if(tokens.empty()) continue;
+
+        auto fail = [&](const char* what) {
+            fprintf(stderr, "%s:%u: %s\n", filePath.c_str(), lineNo, what);
+            return false;
+        };
+
+        if(tokens[0] == "expect") {
+            if(tokens.size() < 3) return fail("expect needs a path and a value");
+            expects.push_back({tokens[1], joinTokens(tokens, 2), lineNo, -1, false, ""});
+            continue;
+        }
+
+        int64_t t = 0, n = 0;
+        if(tokens.size() < 3 || !parseNumber(tokens[0], t) || t < 0) {
+            return fail("expected '<t_ms> <event> ...'");
+        }
+
+        ReplayEvent ev;
+        ev.mTimeMs = t;
+        ev.mLine = lineNo;
+        ev.mPid = 0;
+        ev.mSigCode = 0;
+        ev.mSigType = DEFAULT_SIGNAL_TYPE;
+        ev.mPolicy = SCHED_OTHER;
+        ev.mPriority = 0;
+        ev.mExpect = 0;
+        const std::string& kind = tokens[1];
+
+        if(kind == "exec" || kind == "exit" || kind == "sched") {
+            if(!parseNumber(tokens[2], n) || n <= 0) return fail("bad pid");
+            ev.mPid = static_cast<pid_t>(n);
+        }
+
+        if(kind == "exec") {
+            ev.mKind = EV_EXEC;
+            ev.mSigCode = URM_SIG_APP_OPEN;
+            size_t i = 3;
+            for(; i < tokens.size() && tokens[i] != "--"; i++) {
+                size_t eq = tokens[i].find('=');
+                if(eq == std::string::npos) return fail("expected key=value before '--'");
+                std::string key = tokens[i].substr(0, eq);
+                std::string value = tokens[i].substr(eq + 1);
+                if(key == "comm") {
+                    ev.mComm = value;
+                } else if(key == "cwd") {
+                    ev.mCwd = value;
+                } else if(key == "sig" && parseNumber(value, n)) {
+                    ev.mSigCode = static_cast<uint32_t>(n);
+                } else if(key == "type" && parseNumber(value, n)) {
+                    ev.mSigType = static_cast<uint32_t>(n);
+                } else if(key == "threads") {
+                    for(const std::string& thread : splitList(value)) {
+                        size_t colon = thread.find(':');
+                        if(colon == std::string::npos || !parseNumber(thread.substr(0, colon), n)) {
+                            return fail("threads are tid:comm");
+                        }
+                        ev.mThreads.push_back(std::make_pair(static_cast<pid_t>(n), thread.substr(colon + 1)));
+                    }
+                } else {
+                    return fail("unknown exec field");
+                }
+            }
+            if(i + 1 >= tokens.size()) return fail("exec needs '-- <argv>'");
+            ev.mArgv.assign(tokens.begin() + i + 1, tokens.end());
+            if(ev.mComm.empty()) {
+                ev.mComm = baseName(ev.mArgv[0]);
+            }
+            ev.mComm = ev.mComm.substr(0, REPLAY_COMM_LEN);
+        } else if(kind == "exit") {
+            ev.mKind = EV_EXIT;
+        } else if(kind == "acquire") {
+            ev.mKind = EV_ACQUIRE;
+            ev.mAlias = tokens[2];
+            for(size_t i = 3; i < tokens.size(); i++) {
+                size_t eq = tokens[i].find('=');
+                std::string key = tokens[i].substr(0, eq);
+                if(eq == std::string::npos || !parseNumber(tokens[i].substr(eq + 1), n)) {
+                    return fail("expected sig=, type= or pid=");
+                }
+                if(key == "sig") ev.mSigCode = static_cast<uint32_t>(n);
+                else if(key == "type") ev.mSigType = static_cast<uint32_t>(n);
+                else if(key == "pid") ev.mPid = static_cast<pid_t>(n);
+                else return fail("unknown acquire field");
+            }
+            if(ev.mSigCode == 0) return fail("acquire needs sig=");
+        } else if(kind == "release") {
+            ev.mKind = EV_RELEASE;
+            ev.mAlias = tokens[2];
+        } else if(kind == "node") {
+            if(tokens.size() < 4) return fail("node needs a path and a value");
+            ev.mKind = EV_NODE;
+            ev.mPath = tokens[2];
+            ev.mValue = joinTokens(tokens, 3);
+        } else if(kind == "expect") {
+            if(tokens.size() < 4) return fail("expect needs a path and a value");
+            ev.mKind = EV_EXPECT;
+            ev.mExpect = expects.size();
+            expects.push_back({tokens[2], joinTokens(tokens, 3), lineNo, t, false, ""});
+        } else if(kind == "sched") {
+            if(tokens.size() != 5 || !parsePolicy(tokens[3], ev.mPolicy) || !parseNumber(tokens[4], n)) {
+                return fail("sched needs '<tid> <policy> <priority>'");
+            }
+            ev.mKind = EV_SCHED;
+            ev.mPriority = static_cast<int32_t>(n);
+        } else {
+            return fail("unknown event");
+        }
+        events.push_back(ev);
+    }
+
+    std::stable_sort(events.begin(), events.end(), [](const ReplayEvent& a, const ReplayEvent& b) {
+        return a.mTimeMs < b.mTimeMs;
+    });
+    return true;
+}
+
+static void writeNode(const std::string& path, const std::string& value) {
+    std::ofstream fileStream(path, std::ios::out | std::ios::trunc | std::ios::binary);
+    fileStream << value;
+}
+
+// Creates the /proc entries an exec'd process would have, returns the
+// files written so they are not taken for plugin writes.
+static std::vector<std::string> setupProcess(const ReplayEvent& ev) {
+    std::vector<std::string> written;
+    const std::string procDir = "/proc/" + std::to_string(ev.mPid);
+
+    std::string cmdline;
+    for(const std::string& arg : ev.mArgv) {
+        cmdline += arg;
+        cmdline.push_back('\0');
+    }
+
+    std::vector<std::pair<pid_t, std::string>> threads = ev.mThreads;
+    threads.insert(threads.begin(), std::make_pair(ev.mPid, ev.mComm));
+
+    makeDirs(procDir);
+    writeNode(procDir + "/cmdline", cmdline);
+    writeNode(procDir + "/comm", ev.mComm + "\n");
+    written.push_back(procDir + "/cmdline");
+    written.push_back(procDir + "/comm");
+
+    for(const auto& thread : threads) {
+        const std::string taskDir = procDir + "/task/" + std::to_string(thread.first);
+        makeDirs(taskDir);
+        writeNode(taskDir + "/comm", thread.second.substr(0, REPLAY_COMM_LEN) + "\n");
+        written.push_back(taskDir + "/comm");
+    }
+
+    if(!ev.mCwd.empty()) {
+        unlink((procDir + "/cwd").c_str());
+        if(symlink(ev.mCwd.c_str(), (procDir + "/cwd").c_str()) != 0) {
+            fprintf(stderr, "line %u: cwd symlink: %s\n", ev.mLine, strerror(errno));
+        }
+    }
+    return written;
+}
+
+static std::string hexCode(uint32_t code) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "0x%08x", code);
+    return buf;
+}
+
+static int64_t traceNowMs() {
+    if(gSpeed <= 0.0) {
+        return gTraceNowMs.load(std::memory_order_relaxed);
+    }
+    return static_cast<int64_t>(static_cast<double>(replayMonoNs() - gStartNs) * gSpeed / 1e6);
+}
+
+// Absolute CLOCK_MONOTONIC deadline, wall clock steps do not move it.
+static void sleepUntil(uint64_t monoNs) {
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(monoNs / 1000000000ULL);
+    ts.tv_nsec = static_cast<long>(monoNs % 1000000000ULL);
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+}
+
+// Waits until trace time t. Back to back replays jump to t after letting
+// async work of the previous event settle.
+static void advanceTo(int64_t t, uint32_t settleMs) {
+    if(gSpeed <= 0.0) {
+        sleepUntil(replayMonoNs() + static_cast<uint64_t>(settleMs) * 1000000ULL);
+        if(t > gTraceNowMs.load(std::memory_order_relaxed)) {
+            gTraceNowMs.store(t, std::memory_order_relaxed);
+        }
+        return;
+    }
+    sleepUntil(gStartNs + static_cast<uint64_t>(static_cast<double>(t) * 1e6 / gSpeed));
+}
+
+// Current value behind an expectation path: a node, sched:<tid> or
+// signal:<code>. Returns false if there is nothing to compare against.
+static bool observeExpect(const std::string& path, std::string& got) {
+    got.clear();
+    if(path.compare(0, 6, "sched:") == 0) {
+        pid_t tid = static_cast<pid_t>(strtol(path.c_str() + 6, nullptr, 10));
+        std::map<pid_t, std::pair<int32_t, int32_t>> sched = ReplayCore::getInstance().schedState();
+        auto it = sched.find(tid);
+        if(it == sched.end()) {
+            return false;
+        }
+        got = policyName(it->second.first) + "/" + std::to_string(it->second.second);
+        return true;
+    }
+    if(path.compare(0, 7, "signal:") == 0) {
+        uint32_t sigCode = static_cast<uint32_t>(strtoul(path.c_str() + 7, nullptr, 0));
+        for(uint32_t sigType : ReplayCore::getInstance().heldSigTypes(sigCode)) {
+            if(!got.empty()) got += ",";
+            got += std::to_string(sigType);
+        }
+        return !got.empty();
+    }
+    if(!readLineFromFile(path, got)) {
+        return false;
+    }
+    got = trim(got);
+    return true;
+}
+
+class ReplayRun {
+private:
+    const ReplayOptions& mOpts;
+    std::set<std::string> mSkipDirs;
+    ReplaySnapshot mInitial;
+    ReplaySnapshot mCurrent;
+    std::map<std::string, uint64_t> mSetupWrites;   // Path -> monotonic time written by the replay
+    std::map<std::string, int64_t> mAliases;
+    std::vector<ReplayResult> mResults;
+    bool mOpen;
+
+    void openResult(int64_t t, const std::string& label);
+    void closeResult();
+    void dispatch(const ReplayEvent& ev);
+
+public:
+    explicit ReplayRun(const ReplayOptions& opts) : mOpts(opts), mOpen(false) {
+        mSkipDirs.insert("/usr");
+        mSkipDirs.insert("/etc");
+        mSkipDirs.insert("/dev");
+    }
+
+    bool isSkipped(const std::string& path) const;
+    bool init();
+    void run(const std::vector<ReplayEvent>& events, std::vector<ReplayExpect>& expects);
+    int  report(const std::vector<ReplayExpect>& expects);
+};
+
+bool ReplayRun::isSkipped(const std::string& path) const {
+    for(const std::string& dir : mSkipDirs) {
+        if(path.compare(0, dir.size(), dir) == 0 &&
+           (path.size() == dir.size() || path[dir.size()] == '/')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ReplayRun::init() {
+    void* plugin = dlopen(REPLAY_PLUGIN_INSTALL_PATH, RTLD_NOW | RTLD_GLOBAL);
+    if(plugin == nullptr) {
+        fprintf(stderr, "dlopen: %s\n", dlerror());
+        return false;
+    }
+
+    ReplayCore::getInstance().loadConfigs();
+    ReplayCore::getInstance().setTraceClock(traceNowMs);
+
+    takeSnapshot(mCurrent, mSkipDirs);
+    mInitial = mCurrent;
+    replaySetWriteRecording(true);
+    return true;
+}
+
+void ReplayRun::openResult(int64_t t, const std::string& label) {
+    ReplayResult result;
+    result.mTimeMs = t;
+    result.mLabel = label;
+    result.mStartNs = replayMonoNs();
+    result.mStartWallNs = replayWallNs();
+    result.mCbNs = 0;
+    result.mE2eNs = 0;
+    result.mWrites = result.mAcquires = result.mReleases = result.mSchedChanges = result.mSkipped = 0;
+    mResults.push_back(result);
+    mOpen = true;
+}
+
+// Everything written since the previous event is charged to the open one,
+// the last write or effect bounds its end-to-end latency. Writes are the
+// ones recorded by the open() / fopen() wrappers, plus value, mtime or size
+// changes made some other way.
+void ReplayRun::closeResult() {
+    if(!mOpen) return;
+    mOpen = false;
+    ReplayResult& result = mResults.back();
+    uint64_t lastNs = result.mStartNs + result.mCbNs;
+
+    ReplaySnapshot previous = mCurrent;
+    takeSnapshot(mCurrent, mSkipDirs);
+
+    // Path -> last write, CLOCK_MONOTONIC.
+    std::map<std::string, uint64_t> written;
+    for(const ReplayWrite& write : ReplayCore::getInstance().takeWrites()) {
+        auto setup = mSetupWrites.find(write.mPath);
+        if(setup != mSetupWrites.end() && write.mMonoNs <= setup->second) {
+            continue;
+        }
+        if(isSkipped(write.mPath)) {
+            continue;
+        }
+        uint64_t& last = written[write.mPath];
+        last = std::max(last, write.mMonoNs);
+    }
+
+    // Changes which did not go through open() / fopen(), dated by mtime.
+    for(const auto& kv : mCurrent) {
+        if(written.find(kv.first) != written.end() ||
+           mSetupWrites.find(kv.first) != mSetupWrites.end()) {
+            continue;
+        }
+        auto old = previous.find(kv.first);
+        if(old != previous.end() && old->second.mValue == kv.second.mValue &&
+           old->second.mMtimeNs == kv.second.mMtimeNs && old->second.mSize == kv.second.mSize) {
+            continue;
+        }
+        uint64_t sinceStart = kv.second.mMtimeNs > result.mStartWallNs ?
+                              kv.second.mMtimeNs - result.mStartWallNs : 0;
+        written[kv.first] = result.mStartNs + sinceStart;
+    }
+
+    for(const auto& kv : written) {
+        auto old = previous.find(kv.first);
+        auto now = mCurrent.find(kv.first);
+        result.mWrites++;
+        lastNs = std::max(lastNs, kv.second);
+        result.mDetails.push_back(kv.first + ": " +
+                                  (old != previous.end() ? "'" + old->second.mValue + "'" : "(new)") +
+                                  " -> " +
+                                  (now != mCurrent.end() ? "'" + now->second.mValue + "'" : "(removed)"));
+    }
+    mSetupWrites.clear();
+
+    for(const ReplayEffect& effect : ReplayCore::getInstance().takeEffects()) {
+        if(effect.mWhat.compare(0, 8, "acquire ") == 0) result.mAcquires++;
+        else if(effect.mWhat.compare(0, 8, "release ") == 0) result.mReleases++;
+        else if(effect.mWhat.compare(0, 6, "sched ") == 0) result.mSchedChanges++;
+        lastNs = std::max(lastNs, effect.mMonoNs);
+        result.mDetails.push_back(effect.mWhat);
+    }
+    result.mSkipped = ReplayCore::getInstance().takeSkippedResources();
+    result.mE2eNs = lastNs > result.mStartNs ? lastNs - result.mStartNs : 0;
+}
+
+void ReplayRun::dispatch(const ReplayEvent& ev) {
+    ReplayCore& core = ReplayCore::getInstance();
+    std::vector<std::string> written;
+    std::string label;
+
+    switch(ev.mKind) {
+        case EV_EXEC:
+            written = setupProcess(ev);
+            label = "exec " + ev.mComm + "[" + std::to_string(ev.mPid) + "]";
+            break;
+        case EV_EXIT:
+            label = "exit " + std::to_string(ev.mPid);
+            break;
+        case EV_ACQUIRE:
+            label = "acquire " + ev.mAlias + " " + hexCode(ev.mSigCode) + "/" + std::to_string(ev.mSigType);
+            break;
+        case EV_RELEASE:
+            label = "release " + ev.mAlias;
+            break;
+        case EV_NODE:
+            label = "node " + ev.mPath;
+            written.push_back(ev.mPath);
+            break;
+        case EV_SCHED:
+            label = "sched " + std::to_string(ev.mPid);
+            break;
+        case EV_EXPECT:
+            return;
+    }
+
+    if(ev.mKind == EV_NODE) {
+        writeNode(ev.mPath, ev.mValue);
+    }
+    uint64_t setupDoneNs = replayMonoNs();
+    for(const std::string& path : written) {
+        mSetupWrites[path] = setupDoneNs;
+    }
+
+    openResult(ev.mTimeMs, label);
+    ReplayResult& result = mResults.back();
+    uint64_t startNs = replayMonoNs();
+
+    switch(ev.mKind) {
+        case EV_EXEC: {
+            // URM matches the registered name against the executable name,
+            // comm is cut to 15 characters.
+            std::string procName = baseName(ev.mArgv[0]);
+            if(!core.hasPostProcessor(procName) && core.hasPostProcessor(ev.mComm)) {
+                procName = ev.mComm;
+            }
+            core.launch(ev.mPid, procName, ev.mSigCode, ev.mSigType);
+            break;
+        }
+        case EV_EXIT:
+            removeTree("/proc/" + std::to_string(ev.mPid));
+            core.processExited(ev.mPid);
+            break;
+        case EV_ACQUIRE: {
+            int64_t handle = core.acquire(ev.mSigCode, ev.mSigType, ev.mPid);
+            if(handle > 0) mAliases[ev.mAlias] = handle;
+            break;
+        }
+        case EV_RELEASE: {
+            auto it = mAliases.find(ev.mAlias);
+            if(it != mAliases.end()) {
+                core.release(it->second);
+                mAliases.erase(it);
+            } else {
+                result.mDetails.push_back("no active acquire '" + ev.mAlias + "'");
+            }
+            break;
+        }
+        case EV_NODE:
+            break;
+        case EV_SCHED:
+            if(core.setScheduler(ev.mPid, ev.mPolicy, ev.mPriority, false) != 0) {
+                result.mDetails.push_back("no /proc entry for tid " + std::to_string(ev.mPid));
+            }
+            break;
+        case EV_EXPECT:
+            break;
+    }
+    result.mCbNs = replayMonoNs() - startNs;
+}
+
+void ReplayRun::run(const std::vector<ReplayEvent>& events, std::vector<ReplayExpect>& expects) {
+    ReplayCore& core = ReplayCore::getInstance();
+    gStartNs = replayMonoNs();
+
+    for(const ReplayEvent& ev : events) {
+        // Timed signals falling between two events expire on their own.
+        for(;;) {
+            int64_t deadline = core.nextDeadline();
+            if(deadline < 0 || deadline > ev.mTimeMs) break;
+            advanceTo(deadline, mOpts.mSettleMs);
+            closeResult();
+            openResult(deadline, "expire");
+            uint64_t startNs = replayMonoNs();
+            core.expire(deadline);
+            mResults.back().mCbNs = replayMonoNs() - startNs;
+        }
+
+        advanceTo(ev.mTimeMs, mOpts.mSettleMs);
+        closeResult();
+        if(ev.mKind == EV_EXPECT) {
+            // Not an event of its own, only samples the state at this time.
+            ReplayExpect& expect = expects[ev.mExpect];
+            expect.mFound = observeExpect(expect.mPath, expect.mGot);
+            continue;
+        }
+        dispatch(ev);
+    }
+
+    sleepUntil(replayMonoNs() + static_cast<uint64_t>(mOpts.mSettleMs) * 1000000ULL);
+    closeResult();
+}
+
+static uint64_t percentile(std::vector<uint64_t> values, uint32_t pct) {
+    if(values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t idx = (values.size() - 1) * pct / 100;
+    return values[idx];
+}
+
+int ReplayRun::report(const std::vector<ReplayExpect>& expects) {
+    printf("%4s %8s  %-44s %9s %9s %6s %4s %4s %5s %4s\n",
+           "#", "t_ms", "event", "cb_us", "e2e_us", "writes", "acq", "rel", "sched", "skip");
+
+    std::vector<uint64_t> cbUs, e2eUs;
+    for(size_t i = 0; i < mResults.size(); i++) {
+        const ReplayResult& r = mResults[i];
+        printf("%4zu %8lld  %-44.44s %9llu %9llu %6u %4u %4u %5u %4u\n",
+               i + 1, static_cast<long long>(r.mTimeMs), r.mLabel.c_str(),
+               static_cast<unsigned long long>(r.mCbNs / 1000),
+               static_cast<unsigned long long>(r.mE2eNs / 1000),
+               r.mWrites, r.mAcquires, r.mReleases, r.mSchedChanges, r.mSkipped);
+        if(mOpts.mVerbose) {
+            for(const std::string& detail : r.mDetails) {
+                printf("%15s%s\n", "", detail.c_str());
+            }
+        }
+        cbUs.push_back(r.mCbNs / 1000);
+        e2eUs.push_back(r.mE2eNs / 1000);
+    }
+
+    printf("\nlatency us: cb p50=%llu p95=%llu max=%llu, e2e p50=%llu p95=%llu max=%llu\n",
+           static_cast<unsigned long long>(percentile(cbUs, 50)),
+           static_cast<unsigned long long>(percentile(cbUs, 95)),
+           static_cast<unsigned long long>(percentile(cbUs, 100)),
+           static_cast<unsigned long long>(percentile(e2eUs, 50)),
+           static_cast<unsigned long long>(percentile(e2eUs, 95)),
+           static_cast<unsigned long long>(percentile(e2eUs, 100)));
+
+    // Final state against the initial tree, /proc/<pid> entries created by
+    // the replay itself are left out.
+    std::vector<std::string> changed;
+    for(const auto& kv : mCurrent) {
+        auto it = mInitial.find(kv.first);
+        if(it != mInitial.end() && it->second.mValue == kv.second.mValue) continue;
+        if(it == mInitial.end() && kv.first.compare(0, 6, "/proc/") == 0 &&
+           kv.first.find("/task/") != std::string::npos) continue;
+        changed.push_back(kv.first + ": " + (it != mInitial.end() ? "'" + it->second.mValue + "'" : "(new)") +
+                          " -> '" + kv.second.mValue + "'");
+    }
+    std::map<pid_t, std::pair<int32_t, int32_t>> sched = ReplayCore::getInstance().schedState();
+
+    printf("\nfinal state: %zu nodes differ from the initial tree\n", changed.size());
+    for(const std::string& line : changed) {
+        printf("  %s\n", line.c_str());
+    }
+    for(const auto& kv : sched) {
+        printf("  sched:%d = %s/%d\n", kv.first, policyName(kv.second.first).c_str(), kv.second.second);
+    }
+    printf("active handles: %zu\n", ReplayCore::getInstance().activeHandles());
+
+    uint32_t failed = 0;
+    for(const ReplayExpect& expect : expects) {
+        std::string got = expect.mGot;
+        bool found = expect.mFound;
+        if(expect.mTimeMs < 0) {
+            found = observeExpect(expect.mPath, got);
+        }
+
+        if(!found || got != expect.mValue) {
+            failed++;
+            std::string at = expect.mTimeMs < 0 ? "" : " at " + std::to_string(expect.mTimeMs) + " ms";
+            printf("  FAIL line %u%s: %s want '%s' got %s\n", expect.mLine, at.c_str(), expect.mPath.c_str(),
+                   expect.mValue.c_str(), found ? ("'" + got + "'").c_str() : "(missing)");
+        }
+    }
+    printf("expectations: %zu/%zu passed\n", expects.size() - failed, expects.size());
+    fflush(stdout);
+    return failed == 0 ? 0 : 1;
+}
+
+// Installed configs for the synthetic root, laid out the way CMake installs
+// them under /etc/urm/target.
+static bool seedConfigs(const std::string& configsDir, const std::string& targetDir) {
+    DIR* dir = opendir(configsDir.c_str());
+    if(dir == nullptr) {
+        fprintf(stderr, "%s: %s\n", configsDir.c_str(), strerror(errno));
+        return false;
+    }
+    makeDirs(targetDir);
+
+    bool ok = true;
+    struct dirent* entry;
+    while(ok && (entry = readdir(dir)) != nullptr) {
+        std::string name = entry->d_name;
+        if(name.size() > 5 && name.compare(name.size() - 5, 5, ".yaml") == 0) {
+            ok = copyTree(configsDir + "/" + name, targetDir + "/" + name);
+        }
+    }
+    closedir(dir);
+
+    const std::string specificDir = configsDir + "/target-specific";
+    dir = opendir(specificDir.c_str());
+    while(ok && dir != nullptr && (entry = readdir(dir)) != nullptr) {
+        std::string name = entry->d_name;
+        if(name == "." || name == "..") continue;
+        ok = copyTree(specificDir + "/" + name, targetDir + "/" + name);
+    }
+    if(dir != nullptr) closedir(dir);
+    return ok;
+}
+
+static bool prepareWorkDir(const ReplayOptions& opts, const std::string& workDir) {
+    if(!copyTree(opts.mRoot, workDir)) {
+        fprintf(stderr, "copy %s -> %s failed: %s\n", opts.mRoot.c_str(), workDir.c_str(), strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if(stat((workDir + URM_TARGET_CONFIG_DIR).c_str(), &st) != 0 &&
+       !seedConfigs(opts.mConfigs, workDir + URM_TARGET_CONFIG_DIR)) {
+        return false;
+    }
+
+    makeDirs(workDir + "/proc");
+    makeDirs(workDir + "/sys");
+    makeDirs(workDir + "/tmp");
+    makeDirs(workDir + REPLAY_PLUGIN_INSTALL_DIR);
+    std::string pluginDst = workDir + REPLAY_PLUGIN_INSTALL_PATH;
+    unlink(pluginDst.c_str());
+    if(!copyTree(opts.mPlugin, pluginDst)) {
+        fprintf(stderr, "%s: %s\n", opts.mPlugin.c_str(), strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    ReplayOptions opts;
+    opts.mPlugin = URM_REPLAY_DEFAULT_PLUGIN;
+    opts.mConfigs = URM_REPLAY_DEFAULT_CONFIGS;
+    opts.mSpeed = 1.0;
+    opts.mSettleMs = REPLAY_DEFAULT_SETTLE_MS;
+    opts.mKeep = false;
+    opts.mVerbose = false;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "--root" && hasValue) opts.mRoot = argv[++i];
+        else if(arg == "--trace" && hasValue) opts.mTrace = argv[++i];
+        else if(arg == "--plugin" && hasValue) opts.mPlugin = argv[++i];
+        else if(arg == "--configs" && hasValue) opts.mConfigs = argv[++i];
+        else if(arg == "--work" && hasValue) opts.mWorkDir = argv[++i];
+        else if(arg == "--speed" && hasValue) opts.mSpeed = atof(argv[++i]);
+        else if(arg == "--settle-ms" && hasValue) opts.mSettleMs = static_cast<uint32_t>(atoi(argv[++i]));
+        else if(arg == "--keep") opts.mKeep = true;
+        else if(arg == "-v") opts.mVerbose = true;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if(opts.mRoot.empty() || opts.mTrace.empty() || opts.mSpeed < 0.0) {
+        usage(argv[0]);
+        return 2;
+    }
+    gSpeed = opts.mSpeed;
+    replaySetLogEnabled(opts.mVerbose);
+
+    std::vector<ReplayEvent> events;
+    std::vector<ReplayExpect> expects;
+    if(!parseTrace(opts.mTrace, events, expects)) {
+        return 2;
+    }
+
+    std::string workDir = opts.mWorkDir;
+    if(workDir.empty()) {
+        char tmpl[] = "/tmp/urm-replay.XXXXXX";
+        if(mkdtemp(tmpl) == nullptr) {
+            fprintf(stderr, "mkdtemp: %s\n", strerror(errno));
+            return 2;
+        }
+        workDir = tmpl;
+    }
+    if(!prepareWorkDir(opts, workDir)) {
+        removeTree(workDir);
+        return 2;
+    }
+
+    printf("urm-ext-replay: %zu events, %zu expectations, speed %g, root %s\n",
+           events.size(), expects.size(), opts.mSpeed, workDir.c_str());
+    fflush(stdout);
+
+    // The plugin is loaded inside the synthetic root, the parent only
+    // cleans up once it is done.
+    pid_t child = fork();
+    if(child < 0) {
+        fprintf(stderr, "fork: %s\n", strerror(errno));
+        return 2;
+    }
+    if(child == 0) {
+        if(!enterRoot(workDir)) {
+            _exit(2);
+        }
+        ReplayRun replay(opts);
+        if(!replay.init()) {
+            _exit(2);
+        }
+        replay.run(events, expects);
+        int rc = replay.report(expects);
+        // Plugin threads and destructors must not outlive the report,
+        // their restores would land in the working copy anyway.
+        _exit(rc);
+    }
+
+    int status = 0;
+    while(waitpid(child, &status, 0) < 0 && errno == EINTR) {}
+
+    if(opts.mKeep) {
+        printf("working copy kept in %s\n", workDir.c_str());
+    } else {
+        removeTree(workDir);
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 2;
+}
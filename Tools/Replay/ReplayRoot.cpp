@@ -0,0 +1,189 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#include <vector>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sched.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "Helpers.h"
+#include "ReplayRoot.h"
+
+#define SNAPSHOT_MAX_NODE_SIZE  4096
+
+static bool writeProcFile(const std::string& path, const std::string& value) {
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if(fd < 0) {
+        return false;
+    }
+    ssize_t rc = write(fd, value.data(), value.size());
+    close(fd);
+    return rc == static_cast<ssize_t>(value.size());
+}
+
+static bool copyFile(const std::string& src, const std::string& dst, mode_t mode) {
+    int in = open(src.c_str(), O_RDONLY | O_CLOEXEC);
+    if(in < 0) {
+        return false;
+    }
+    int out = open(dst.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode | S_IWUSR);
+    if(out < 0) {
+        close(in);
+        return false;
+    }
+
+    bool ok = true;
+    char buf[65536];
+    ssize_t n = 0;
+    while((n = read(in, buf, sizeof(buf))) > 0) {
+        if(write(out, buf, n) != n) {
+            ok = false;
+            break;
+        }
+    }
+    close(in);
+    close(out);
+    return ok && n == 0;
+}
+
+bool copyTree(const std::string& src, const std::string& dst) {
+    struct stat st;
+    if(lstat(src.c_str(), &st) != 0) {
+        return false;
+    }
+
+    if(S_ISLNK(st.st_mode)) {
+        std::vector<char> target(st.st_size + 1, '\0');
+        ssize_t len = readlink(src.c_str(), target.data(), st.st_size);
+        return len >= 0 && symlink(target.data(), dst.c_str()) == 0;
+    }
+    if(S_ISREG(st.st_mode)) {
+        return copyFile(src, dst, st.st_mode & 07777);
+    }
+    if(!S_ISDIR(st.st_mode)) {
+        // Device nodes, fifos and sockets have no meaning in the replay.
+        return true;
+    }
+
+    if(mkdir(dst.c_str(), (st.st_mode & 07777) | S_IRWXU) != 0 && errno != EEXIST) {
+        return false;
+    }
+
+    DIR* dir = opendir(src.c_str());
+    if(dir == nullptr) {
+        return false;
+    }
+    bool ok = true;
+    struct dirent* entry;
+    while(ok && (entry = readdir(dir)) != nullptr) {
+        std::string name = entry->d_name;
+        if(name == "." || name == "..") continue;
+        ok = copyTree(src + "/" + name, dst + "/" + name);
+    }
+    closedir(dir);
+    return ok;
+}
+
+void removeTree(const std::string& path) {
+    struct stat st;
+    if(lstat(path.c_str(), &st) != 0) {
+        return;
+    }
+    if(S_ISDIR(st.st_mode)) {
+        DIR* dir = opendir(path.c_str());
+        if(dir != nullptr) {
+            struct dirent* entry;
+            while((entry = readdir(dir)) != nullptr) {
+                std::string name = entry->d_name;
+                if(name == "." || name == "..") continue;
+                removeTree(path + "/" + name);
+            }
+            closedir(dir);
+        }
+        rmdir(path.c_str());
+        return;
+    }
+    unlink(path.c_str());
+}
+
+bool makeDirs(const std::string& path) {
+    size_t pos = 0;
+    while((pos = path.find('/', pos + 1)) != std::string::npos) {
+        mkdir(path.substr(0, pos).c_str(), 0755);
+    }
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool enterRoot(const std::string& workDir) {
+    if(geteuid() != 0) {
+        uid_t uid = geteuid();
+        gid_t gid = getegid();
+        if(unshare(CLONE_NEWUSER | CLONE_NEWNS) != 0) {
+            fprintf(stderr, "unshare: %s\n", strerror(errno));
+            return false;
+        }
+        if(!writeProcFile("/proc/self/setgroups", "deny") ||
+           !writeProcFile("/proc/self/uid_map", "0 " + std::to_string(uid) + " 1") ||
+           !writeProcFile("/proc/self/gid_map", "0 " + std::to_string(gid) + " 1")) {
+            fprintf(stderr, "id mapping: %s\n", strerror(errno));
+            return false;
+        }
+    }
+
+    if(chroot(workDir.c_str()) != 0 || chdir("/") != 0) {
+        fprintf(stderr, "chroot %s: %s\n", workDir.c_str(), strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+static void snapshotDir(const std::string& dirPath, ReplaySnapshot& snapshot,
+                        const std::set<std::string>& skipDirs) {
+    DIR* dir = opendir(dirPath.empty() ? "/" : dirPath.c_str());
+    if(dir == nullptr) {
+        return;
+    }
+
+    struct dirent* entry;
+    while((entry = readdir(dir)) != nullptr) {
+        std::string name = entry->d_name;
+        if(name == "." || name == "..") continue;
+
+        std::string path = dirPath + "/" + name;
+        struct stat st;
+        if(lstat(path.c_str(), &st) != 0) continue;
+
+        if(S_ISDIR(st.st_mode)) {
+            if(skipDirs.find(path) == skipDirs.end()) {
+                snapshotDir(path, snapshot, skipDirs);
+            }
+            continue;
+        }
+        if(!S_ISREG(st.st_mode)) continue;
+
+        ReplayNodeState node;
+        node.mMtimeNs = static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000ULL +
+                        static_cast<uint64_t>(st.st_mtim.tv_nsec);
+        node.mSize = st.st_size;
+
+        // Always re-read: mtime and size miss a same-size rewrite within
+        // one clock tick.
+        if(st.st_size <= SNAPSHOT_MAX_NODE_SIZE) {
+            std::string line;
+            readLineFromFile(path, line);
+            node.mValue = trim(line);
+        }
+        snapshot[path] = node;
+    }
+    closedir(dir);
+}
+
+void takeSnapshot(ReplaySnapshot& snapshot, const std::set<std::string>& skipDirs) {
+    snapshot.clear();
+    snapshotDir("", snapshot, skipDirs);
+}
@@ -0,0 +1,42 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_REPLAY_ROOT_H
+#define URM_REPLAY_ROOT_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <cstdint>
+
+// Recursive copy of files, directories and symlinks, dst must not exist.
+bool copyTree(const std::string& src, const std::string& dst);
+void removeTree(const std::string& path);
+bool makeDirs(const std::string& path);
+
+/**
+ * @brief Make workDir the root of the calling process.
+ *
+ * Unprivileged callers first enter a new user and mount namespace, mapping
+ * their uid to root, so the plugin can chroot and write nodes inside the
+ * tree without touching the host. Must run before any thread is started.
+ */
+bool enterRoot(const std::string& workDir);
+
+typedef struct {
+    uint64_t    mMtimeNs;
+    int64_t     mSize;
+    std::string mValue;     // First line, trimmed
+} ReplayNodeState;
+
+typedef std::map<std::string, ReplayNodeState> ReplaySnapshot;
+
+/**
+ * @brief Record every regular file below "/" except the skipped subtrees.
+ *
+ * Only the first line of small files is kept, which is what sysfs and
+ * procfs nodes hold.
+ */
+void takeSnapshot(ReplaySnapshot& snapshot, const std::set<std::string>& skipDirs);
+
+#endif
@@ -0,0 +1,41 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+// Replay stand-in for the URM core header, registrations land in the
+// urm-ext-replay callback tables instead of the URM registries.
+
+#ifndef URM_REPLAY_EXTENSIONS_H
+#define URM_REPLAY_EXTENSIONS_H
+
+#include <cstdint>
+#include <sys/types.h>
+
+typedef void (*ResourceLifecycleCallback)(void*);
+typedef void (*PostProcessingCallback)(void*);
+
+struct PostProcessCBData {
+    pid_t    mPid;
+    uint32_t mSigId;
+    uint32_t mSigType;
+    int64_t  mHandleAcq;
+};
+
+int32_t replayRegisterResourceCallback(uint32_t resCode, ResourceLifecycleCallback cb, bool tear);
+int32_t replayRegisterPostProcessCallback(const char* procName, PostProcessingCallback cb);
+
+#define URM_REPLAY_CAT2(a, b) a##b
+#define URM_REPLAY_CAT(a, b) URM_REPLAY_CAT2(a, b)
+
+#define URM_REGISTER_RES_APPLIER_CB(resCode, cb) \
+    static int32_t __attribute__((unused)) URM_REPLAY_CAT(urmReplayApply, __LINE__) = \
+        replayRegisterResourceCallback(resCode, cb, false);
+
+#define URM_REGISTER_RES_TEAR_CB(resCode, cb) \
+    static int32_t __attribute__((unused)) URM_REPLAY_CAT(urmReplayTear, __LINE__) = \
+        replayRegisterResourceCallback(resCode, cb, true);
+
+#define URM_REGISTER_POST_PROCESS_CB(procName, cb) \
+    static int32_t __attribute__((unused)) URM_REPLAY_CAT(urmReplayPostProcess, __LINE__) = \
+        replayRegisterPostProcessCallback(procName, cb);
+
+#endif
@@ -0,0 +1,34 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+// Replay stand-in for the URM Logger. Keeps the system headers the URM
+// header makes available to the plugin sources.
+
+#ifndef URM_REPLAY_LOGGER_H
+#define URM_REPLAY_LOGGER_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <dirent.h>
+#include <unistd.h>
+
+enum LogType {
+    ERRNO_LOG,
+    NOTIFY_NODE_WRITE_S,
+    NOTIFY_NODE_RESET,
+};
+
+void replayLog(char level, const std::string& tag, const std::string& msg);
+
+#define LOGD(tag, msg) replayLog('D', tag, msg)
+#define LOGI(tag, msg) replayLog('I', tag, msg)
+#define LOGW(tag, msg) replayLog('W', tag, msg)
+#define LOGE(tag, msg) replayLog('E', tag, msg)
+
+// Node writes are picked up from the synthetic tree itself.
+#define TYPELOGV(type, ...) do { (void)(type); } while(0)
+
+#endif
@@ -0,0 +1,29 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_REPLAY_RESOURCE_H
+#define URM_REPLAY_RESOURCE_H
+
+#include <vector>
+#include <cstdint>
+
+// Replay stand-in for the URM Resource handed to applier / tear callbacks.
+class Resource {
+private:
+    uint32_t mResCode;
+    uint32_t mResInfo;
+    std::vector<int32_t> mValues;
+
+public:
+    Resource(uint32_t resCode, uint32_t resInfo, const std::vector<int32_t>& values)
+        : mResCode(resCode), mResInfo(resInfo), mValues(values) {}
+
+    uint32_t getResCode() const { return mResCode; }
+    uint32_t getResInfo() const { return mResInfo; }
+    int32_t getValuesCount() const { return static_cast<int32_t>(mValues.size()); }
+    int32_t getValueAt(int32_t i) const {
+        return (i >= 0 && i < getValuesCount()) ? mValues[i] : -1;
+    }
+};
+
+#endif
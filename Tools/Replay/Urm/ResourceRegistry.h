@@ -0,0 +1,17 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_REPLAY_RESOURCE_REGISTRY_H
+#define URM_REPLAY_RESOURCE_REGISTRY_H
+
+#include <string>
+
+// Replay stand-in for the URM file helpers, backed by the synthetic tree.
+class AuxRoutines {
+public:
+    static bool fileExists(const std::string& path);
+    static std::string readFromFile(const std::string& path);
+    static void writeToFile(const std::string& path, const std::string& value);
+};
+
+#endif
@@ -0,0 +1,23 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_REPLAY_SIGNAL_INTERNAL_H
+#define URM_REPLAY_SIGNAL_INTERNAL_H
+
+#include <cstdint>
+#include <sys/types.h>
+
+enum SignalExtraAttr {
+    SIGNAL_EXTRA_ATTR_FPS = 0,
+    SIGNAL_EXTRA_ATTR_HEIGHT,
+    SIGNAL_EXTRA_ATTR_WIDTH,
+    SIGNAL_EXTRA_ATTR_SRC_ELEMENT,
+    SIGNAL_EXTRA_ATTRS_COUNT,
+};
+
+// Resolved against the replay signal table, see Tools/Replay/ReplayCore.cpp.
+int64_t acquireSignal(uint32_t sigCode, uint32_t sigType, pid_t pid, pid_t tid,
+                      int32_t numArgs, uint32_t* extraArgs);
+int8_t releaseSignal(int64_t handle, pid_t pid, pid_t tid);
+
+#endif
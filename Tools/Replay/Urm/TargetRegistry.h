@@ -0,0 +1,21 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_REPLAY_TARGET_REGISTRY_H
+#define URM_REPLAY_TARGET_REGISTRY_H
+
+#include <cstdint>
+
+enum TargetInfoQuery {
+    GET_MASK = 0,
+};
+
+enum TargetInfoArg {
+    GET_MAX_CLUSTER = 0,
+};
+
+// Only GET_MASK of GET_MAX_CLUSTER is answered, from the cpufreq policies
+// of the synthetic tree.
+uint64_t GET_TARGET_INFO(int32_t query, int32_t numArgs, int32_t* args);
+
+#endif
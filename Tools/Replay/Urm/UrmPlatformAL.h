@@ -0,0 +1,22 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause-Clear
+
+#ifndef URM_REPLAY_PLATFORM_AL_H
+#define URM_REPLAY_PLATFORM_AL_H
+
+#include <cstdint>
+
+#define CONSTRUCT_SIG_CODE(category, sigId) \
+    ((static_cast<uint32_t>(category) << 16) | static_cast<uint32_t>(sigId))
+
+#define DEFAULT_SIGNAL_TYPE 0
+
+enum UrmSignalCode : uint32_t {
+    URM_SIG_APP_OPEN                    = 0x00010001,
+    URM_SIG_VIDEO_DECODE                = 0x00030001,
+    URM_SIG_CAMERA_PREVIEW              = 0x00030002,
+    URM_SIG_CAMERA_ENCODE               = 0x00030003,
+    URM_SIG_CAMERA_ENCODE_MULTI_STREAMS = 0x00030004,
+};
+
+#endif